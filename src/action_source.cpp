@@ -0,0 +1,858 @@
+#include "action_source.hpp"
+#include "json_reader.hpp"
+#include "logger.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unordered_set>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PrimeCuts {
+
+namespace {
+
+std::string expandHome(const std::string& path) {
+    if (path.size() >= 2 && path[0] == '~' && path[1] == '/') {
+        return std::string(g_get_home_dir()) + path.substr(1);
+    }
+    return path;
+}
+
+std::string slugify(const std::string& text) {
+    std::string slug;
+    for (char c : text) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            slug += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        } else if (!slug.empty() && slug.back() != '_') {
+            slug += '_';
+        }
+    }
+    while (!slug.empty() && slug.back() == '_') {
+        slug.pop_back();
+    }
+    return slug.empty() ? "source" : slug;
+}
+
+// The cache uses tabs and newlines as separators, so generated fields must not contain them
+std::string sanitizeField(const std::string& field) {
+    std::string result = field;
+    std::replace_if(result.begin(), result.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return result;
+}
+
+std::string trim(const std::string& str) {
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+std::vector<std::string> splitWhitespace(const std::string& str) {
+    std::vector<std::string> tokens;
+    std::istringstream stream(str);
+    std::string token;
+    while (stream >> token) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) {
+            break;
+        }
+        start = tab + 1;
+    }
+    return fields;
+}
+
+// How fillItem puts an item into the source command
+enum class ItemText {
+    WORD,   // A host, unit, path or name: one shell word, or URL-encoded for URL actions
+    COMMAND // A command line or URL that is run as it is
+};
+
+std::string fillItem(const ActionSource& source, const std::string& item, ItemText text = ItemText::WORD) {
+    const std::string placeholder = Constants::SOURCE_ITEM_PLACEHOLDER;
+    // A URL action whose command is only the placeholder opens the item itself
+    bool whole_url = source.action_type == ActionType::URL && source.command == placeholder;
+
+    std::string result;
+    size_t start = 0;
+    size_t pos = 0;
+    while ((pos = source.command.find(placeholder, start)) != std::string::npos) {
+        result.append(source.command, start, pos - start);
+        if (text == ItemText::COMMAND || whole_url) {
+            result += item;
+        } else if (source.action_type == ActionType::URL) {
+            appendUrlEncoded(result, item);
+        } else {
+            appendShellQuoted(result, item);
+        }
+        start = pos + placeholder.length();
+    }
+    result.append(source.command, start, std::string::npos);
+    return result;
+}
+
+Action makeAction(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                  const std::string& item, const std::string& name, const std::string& description,
+                  const std::string& command, std::vector<std::string> keywords) {
+    Action action(
+        Constants::SOURCE_ID_PREFIX + slugify(group_name) + ":" + sanitizeField(item),
+        sanitizeField(name),
+        sanitizeField(description),
+        group_icon,
+        source.action_type,
+        sanitizeField(command),
+        {});
+    action.expand_placeholders = false; // The command holds item text, which may contain braces
+    for (auto& keyword : keywords) {
+        action.keywords.push_back(sanitizeField(keyword));
+    }
+    return action;
+}
+
+bool runGeneratorCommand(const std::string& command, std::string& output) {
+    gchar* standard_output = nullptr;
+    gint wait_status = 0;
+    GError* error = nullptr;
+
+    if (!g_spawn_command_line_sync(command.c_str(), &standard_output, nullptr, &wait_status, &error)) {
+        LOG_WARNING("Failed to run source generator '" + command + "': " + std::string(error ? error->message : "Unknown error"));
+        if (error) g_error_free(error);
+        return false;
+    }
+
+    if (!g_spawn_check_wait_status(wait_status, &error)) {
+        LOG_WARNING("Source generator '" + command + "' failed: " + std::string(error ? error->message : "Unknown error"));
+        if (error) g_error_free(error);
+        g_free(standard_output);
+        return false;
+    }
+
+    output = standard_output ? standard_output : "";
+    g_free(standard_output);
+    return true;
+}
+
+bool generateSshHosts(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                      std::vector<Action>& actions) {
+    std::ifstream file(expandHome(source.path));
+    if (!file.is_open()) {
+        LOG_WARNING("Cannot read SSH config: " + source.path);
+        return false;
+    }
+
+    std::vector<size_t> block; // Actions created by the current "Host" line
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::replace(line.begin(), line.end(), '=', ' ');
+        std::vector<std::string> tokens = splitWhitespace(line);
+        if (tokens.empty()) {
+            continue;
+        }
+        std::string keyword = tokens[0];
+        std::transform(keyword.begin(), keyword.end(), keyword.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (keyword == "host") {
+            block.clear();
+            for (size_t i = 1; i < tokens.size(); ++i) {
+                const std::string& host = tokens[i];
+                if (host.find_first_of("*?!") != std::string::npos) {
+                    continue; // Patterns are not connectable hosts
+                }
+                block.push_back(actions.size());
+                actions.push_back(makeAction(group_name, group_icon, source, host, host, "SSH to " + host,
+                                             fillItem(source, host), {"ssh", host}));
+            }
+        } else if (keyword == "hostname" && tokens.size() > 1) {
+            for (size_t index : block) {
+                actions[index].description = "SSH to " + tokens[1];
+                actions[index].keywords.push_back(tokens[1]);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool generateSystemdUnits(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                          std::vector<Action>& actions) {
+    std::string output;
+    if (!runGeneratorCommand(source.generator, output)) {
+        return false;
+    }
+
+    std::istringstream stream(output);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::vector<std::string> tokens = splitWhitespace(line);
+        if (tokens.empty()) {
+            continue;
+        }
+
+        const std::string& unit = tokens[0];
+        std::string base_name = unit.substr(0, unit.find('.'));
+        std::string state = tokens.size() > 1 ? " (" + tokens[1] + ")" : "";
+        actions.push_back(makeAction(group_name, group_icon, source, unit, unit, "systemd unit" + state,
+                                     fillItem(source, unit), {"systemd", base_name}));
+    }
+
+    return true;
+}
+
+bool generateDirectories(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                         std::vector<Action>& actions) {
+    std::string root = expandHome(source.path);
+    DIR* dir = opendir(root.c_str());
+    if (!dir) {
+        LOG_WARNING("Cannot open source directory: " + root);
+        return false;
+    }
+
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string full_path = root + "/" + entry->d_name;
+        struct stat st;
+        if (stat(full_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    // readdir order is arbitrary, keep the generated output stable across runs
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names) {
+        std::string full_path = root + "/" + name;
+        actions.push_back(makeAction(group_name, group_icon, source, full_path, name, full_path,
+                                     fillItem(source, full_path), {name}));
+    }
+
+    return true;
+}
+
+// Script output: one action per line as "name[<TAB>command[<TAB>description[<TAB>keywords]]]"
+bool generateFromScript(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                        std::vector<Action>& actions) {
+    std::string output;
+    if (!runGeneratorCommand(expandHome(source.generator), output)) {
+        return false;
+    }
+
+    std::istringstream stream(output);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (trim(line).empty()) {
+            continue;
+        }
+
+        std::vector<std::string> fields = splitTabs(line);
+        std::string name = trim(fields[0]);
+        std::string command = fields.size() > 1 ? fields[1]
+            : (source.command.empty() ? name : fillItem(source, name));
+        std::string description = fields.size() > 2 ? fields[2] : "";
+        std::vector<std::string> keywords = fields.size() > 3 ? splitWhitespace(fields[3]) : std::vector<std::string>{};
+
+        actions.push_back(makeAction(group_name, group_icon, source, name, name, description, command, keywords));
+    }
+
+    return true;
+}
+
+// "path" replaces the XDG data directories, several directories are separated by ':'
+std::vector<std::string> desktopEntryDirs(const ActionSource& source) {
+    std::vector<std::string> dirs;
+    if (!source.path.empty()) {
+        std::istringstream stream(source.path);
+        std::string dir;
+        while (std::getline(stream, dir, ':')) {
+            if (!dir.empty()) dirs.push_back(expandHome(dir));
+        }
+        return dirs;
+    }
+
+    dirs.push_back(std::string(g_get_user_data_dir()) + "/applications");
+    for (const gchar* const* dir = g_get_system_data_dirs(); *dir; ++dir) {
+        dirs.push_back(std::string(*dir) + "/applications");
+    }
+    return dirs;
+}
+
+bool programExists(const std::string& program) {
+    gchar* found = g_find_program_in_path(program.c_str());
+    g_free(found);
+    return found != nullptr;
+}
+
+// Only files whose mtime, size or inode changed since the previous run are parsed again;
+// the rest of the scan is one readdir and one stat per file
+bool generateDesktopEntries(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                            DesktopEntryCache& cache, std::vector<Action>& actions) {
+    std::vector<std::string> languages;
+    for (const gchar* const* language = g_get_language_names(); *language; ++language) {
+        if (std::string(*language) != "C") languages.push_back(*language);
+    }
+    std::vector<std::string> current_desktops;
+    std::istringstream desktops(g_getenv("XDG_CURRENT_DESKTOP") ? g_getenv("XDG_CURRENT_DESKTOP") : "");
+    std::string desktop;
+    while (std::getline(desktops, desktop, ':')) {
+        current_desktops.push_back(desktop);
+    }
+
+    const std::string suffix = ".desktop";
+    DesktopEntryCache scanned;
+    std::unordered_set<std::string> seen_ids;
+    size_t reparsed = 0;
+    for (const auto& dir_path : desktopEntryDirs(source)) {
+        DIR* dir = opendir(dir_path.c_str());
+        if (!dir) {
+            continue; // Not every data directory has applications
+        }
+        std::vector<std::string> names;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                names.push_back(std::move(name));
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+
+        for (const auto& name : names) {
+            // An earlier directory shadows the same desktop id, also when its entry is hidden
+            if (!seen_ids.insert(name).second) {
+                continue;
+            }
+
+            std::string full_path = dir_path + "/" + name;
+            struct stat st;
+            if (stat(full_path.c_str(), &st) != 0) {
+                continue;
+            }
+
+            CachedDesktopEntry file;
+            file.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+            file.size = static_cast<int64_t>(st.st_size);
+            file.inode = static_cast<uint64_t>(st.st_ino);
+
+            auto cached = cache.find(full_path);
+            if (cached != cache.end() && cached->second.mtime_ns == file.mtime_ns &&
+                cached->second.size == file.size && cached->second.inode == file.inode) {
+                file.entry = std::move(cached->second.entry);
+            } else if (parseDesktopEntry(full_path, languages, current_desktops, file.entry)) {
+                reparsed++;
+            } else {
+                LOG_DEBUG("Cannot read desktop entry: " + full_path);
+                continue;
+            }
+
+            const DesktopEntry& entry = file.entry;
+            if (entry.visible && (entry.try_exec.empty() || programExists(entry.try_exec))) {
+                std::string id = name.substr(0, name.size() - suffix.size());
+                std::vector<std::string> keywords = entry.keywords;
+                for (auto& word : splitWhitespace(entry.generic_name)) {
+                    keywords.push_back(std::move(word));
+                }
+                std::string program = entry.exec.substr(0, entry.exec.find(' '));
+                keywords.push_back(program.substr(program.rfind('/') + 1));
+
+                // Terminal applications run in the terminal as they are, the rest through the source command
+                Action action = makeAction(group_name, group_icon, source, id, entry.name,
+                                           entry.comment.empty() ? entry.generic_name : entry.comment,
+                                           entry.terminal ? entry.exec : fillItem(source, entry.exec, ItemText::COMMAND),
+                                           std::move(keywords));
+                if (entry.terminal) {
+                    action.type = ActionType::TERMINAL_COMMAND;
+                }
+                if (!entry.icon.empty()) {
+                    action.icon = sanitizeField(entry.icon);
+                }
+                actions.push_back(std::move(action));
+            }
+            scanned.emplace(std::move(full_path), std::move(file));
+        }
+    }
+
+    // Files that are gone drop out of the cache here
+    cache.swap(scanned);
+    LOG_DEBUG("Desktop entries for " + group_name + ": parsed " + std::to_string(reparsed) + " of "
+              + std::to_string(cache.size()) + " files");
+    return true;
+}
+
+// Reads only the part of the history file appended since the previous run, and emits
+// the actions only if that changed the listed commands or their order
+bool generateShellHistory(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                          ShellHistory& history, uint64_t& history_generation, bool& unchanged,
+                          std::vector<Action>& actions) {
+    std::string path = expandHome(source.path);
+    if (!history.update(path, source.max_items)) {
+        LOG_WARNING("Cannot read shell history: " + path);
+        return false;
+    }
+    if (history.generation() == history_generation) {
+        unchanged = true;
+        return true;
+    }
+    history_generation = history.generation();
+
+    // Commands can be long and contain anything, the id only needs to be stable
+    char item[17];
+    history.forEachRecentFirst([&](const std::string& command) {
+        snprintf(item, sizeof(item), "%016zx", std::hash<std::string>{}(command));
+        actions.push_back(makeAction(group_name, group_icon, source, item, command, "From shell history",
+                                     fillItem(source, command, ItemText::COMMAND), {}));
+    });
+    return true;
+}
+
+// Collects the "url" nodes of a Chromium bookmark file. Folders list their children before
+// their name, so folder names are added to the bookmarks when the folder object ends.
+class BookmarkHandler : public JsonHandler {
+public:
+    struct Bookmark {
+        std::string name;
+        std::string url;
+        std::vector<std::string> folders;
+    };
+
+    std::vector<Bookmark> bookmarks;
+
+    void startObject() override {
+        frames_.push_back(Frame{});
+        frames_.back().first_bookmark = bookmarks.size();
+        containers_.push_back(false);
+    }
+
+    void endObject() override {
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        containers_.pop_back();
+
+        if (frame.type == "url" && !frame.url.empty()) {
+            bookmarks.push_back({frame.name.empty() ? frame.url : std::move(frame.name), std::move(frame.url), {}});
+        } else if (frame.type == "folder" && !frame.name.empty()) {
+            for (size_t i = frame.first_bookmark; i < bookmarks.size(); ++i) {
+                bookmarks[i].folders.push_back(frame.name);
+            }
+        }
+    }
+
+    void startArray() override { containers_.push_back(true); }
+    void endArray() override { containers_.pop_back(); }
+    void key(std::string_view name) override { key_.assign(name); }
+
+    void string(std::string_view value) override {
+        if (frames_.empty() || containers_.back()) {
+            return;
+        }
+        if (key_ == "type") {
+            frames_.back().type.assign(value);
+        } else if (key_ == "name") {
+            frames_.back().name.assign(value);
+        } else if (key_ == "url") {
+            frames_.back().url.assign(value);
+        }
+    }
+
+private:
+    struct Frame {
+        std::string type;
+        std::string name;
+        std::string url;
+        size_t first_bookmark = 0;
+    };
+
+    std::vector<Frame> frames_;
+    std::vector<bool> containers_; // true for arrays
+    std::string key_;
+};
+
+std::string urlHost(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    std::string host = url.substr(start, url.find_first_of("/?#:", start) - start);
+    return host.compare(0, 4, "www.") == 0 ? host.substr(4) : host;
+}
+
+// Parses the whole file, but only when its mtime differs from the previous successful run
+bool generateBookmarks(const std::string& group_name, const std::string& group_icon, const ActionSource& source,
+                       int64_t& source_mtime, bool& unchanged, std::vector<Action>& actions) {
+    std::string path = expandHome(source.path);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOG_WARNING("Cannot read bookmarks: " + path);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    if (mtime == source_mtime) {
+        close(fd);
+        unchanged = true;
+        return true;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_WARNING("Cannot map bookmarks: " + path);
+        return false;
+    }
+
+    gint64 start_time = g_get_monotonic_time();
+    BookmarkHandler handler;
+    JsonReader reader(std::string_view(static_cast<const char*>(data), size));
+    bool parsed = reader.parse(handler);
+    gint64 elapsed_us = std::max<gint64>(g_get_monotonic_time() - start_time, 1);
+    munmap(data, size);
+
+    if (!parsed) {
+        LOG_WARNING("Invalid bookmarks file " + path + ": " + reader.error());
+        return false;
+    }
+
+    std::unordered_set<std::string> seen_urls;
+    char item[17];
+    for (auto& bookmark : handler.bookmarks) {
+        if (!seen_urls.insert(bookmark.url).second) {
+            continue;
+        }
+        std::vector<std::string> keywords;
+        std::string host = urlHost(bookmark.url);
+        if (!host.empty()) keywords.push_back(host);
+        for (const auto& folder : bookmark.folders) {
+            for (auto& word : splitWhitespace(folder)) {
+                keywords.push_back(std::move(word));
+            }
+        }
+
+        snprintf(item, sizeof(item), "%016zx", std::hash<std::string>{}(bookmark.url));
+        actions.push_back(makeAction(group_name, group_icon, source, item, bookmark.name, bookmark.url,
+                                     fillItem(source, bookmark.url), std::move(keywords)));
+    }
+    source_mtime = mtime;
+
+    // Bytes per microsecond is MB/s
+    char throughput[32];
+    snprintf(throughput, sizeof(throughput), "%.1f", static_cast<double>(size) / static_cast<double>(elapsed_us));
+    LOG_INFO("Read " + std::to_string(actions.size()) + " bookmarks from " + std::to_string(size) + " bytes in "
+             + std::to_string(elapsed_us) + " us (" + throughput + " MB/s)");
+    return true;
+}
+
+} // anonymous namespace
+
+SourceManager::SourceManager(CommandManager& command_manager, const Config& config)
+    : command_manager_(command_manager)
+    , cancellable_(g_cancellable_new()) {
+    for (const auto& group : config.groups) {
+        if (!group.source) {
+            continue;
+        }
+
+        auto state = std::make_unique<SourceState>();
+        state->manager = this;
+        state->group_name = group.name;
+        state->group_icon = group.icon;
+        state->source = *group.source;
+        state->static_actions = group.actions;
+
+        gchar* cache_path = g_build_filename(g_get_user_cache_dir(), Constants::SOURCE_CACHE_SUBDIR,
+                                             (slugify(group.name) + ".tsv").c_str(), nullptr);
+        state->cache_path = cache_path;
+        g_free(cache_path);
+
+        sources_.push_back(std::move(state));
+    }
+}
+
+SourceManager::~SourceManager() {
+    // Generators still running finish on their own, their results are dropped
+    g_cancellable_cancel(cancellable_);
+
+    for (auto& state : sources_) {
+        if (state->timer_id > 0) {
+            g_source_remove(state->timer_id);
+        }
+        for (GFileMonitor* monitor : state->monitors) {
+            g_file_monitor_cancel(monitor);
+            g_object_unref(monitor);
+        }
+    }
+
+    g_object_unref(cancellable_);
+}
+
+void SourceManager::start() {
+    for (auto& state : sources_) {
+        loadCachedActions(*state);
+        watchSource(*state);
+
+        if (state->source.refresh_interval > 0) {
+            state->timer_id = g_timeout_add_seconds(state->source.refresh_interval, onRefreshTimer, state.get());
+        }
+
+        scheduleRefresh(*state);
+    }
+
+    LOG_DEBUG("Started " + std::to_string(sources_.size()) + " action sources");
+}
+
+void SourceManager::refreshAll() {
+    for (auto& state : sources_) {
+        scheduleRefresh(*state);
+    }
+}
+
+void SourceManager::loadCachedActions(SourceState& state) {
+    std::vector<Action> actions;
+    if (!loadCache(state.cache_path, actions)) {
+        return;
+    }
+
+    state.output_hash = std::hash<std::string>{}(serializeActions(actions));
+    LOG_DEBUG("Loaded " + std::to_string(actions.size()) + " cached actions for source: " + state.group_name);
+    mergeActions(state, std::move(actions));
+}
+
+void SourceManager::mergeActions(SourceState& state, std::vector<Action> generated) {
+    // Actions listed in config.json stay in front of the generated ones
+    generated.insert(generated.begin(), state.static_actions.begin(), state.static_actions.end());
+    command_manager_.replaceGroupActions(state.group_name, std::move(generated));
+}
+
+void SourceManager::watchSource(SourceState& state) {
+    std::vector<std::string> paths;
+    if (state.source.type == SourceType::DESKTOP_ENTRIES) {
+        paths = desktopEntryDirs(state.source);
+    } else if (!state.source.path.empty()) {
+        paths.push_back(expandHome(state.source.path));
+    }
+
+    for (const auto& path : paths) {
+        GFile* file = g_file_new_for_path(path.c_str());
+        GError* error = nullptr;
+        GFileMonitor* monitor = g_file_monitor(file, G_FILE_MONITOR_NONE, nullptr, &error);
+        g_object_unref(file);
+
+        if (!monitor) {
+            LOG_WARNING("Cannot watch source path " + path + ": " + std::string(error ? error->message : "Unknown error"));
+            if (error) g_error_free(error);
+            continue;
+        }
+
+        // Editors emit bursts of events for one save
+        g_file_monitor_set_rate_limit(monitor, 1000);
+        g_signal_connect(monitor, "changed", G_CALLBACK(onSourceChanged), &state);
+        state.monitors.push_back(monitor);
+    }
+}
+
+void SourceManager::scheduleRefresh(SourceState& state) {
+    if (state.running) {
+        // Rerun once the current generator is done so its result is not stale
+        state.pending = true;
+        return;
+    }
+
+    state.running = true;
+    state.pending = false;
+
+    auto* job = new GeneratorJob();
+    job->state = &state;
+    job->group_name = state.group_name;
+    job->group_icon = state.group_icon;
+    job->source = state.source;
+    job->cache_path = state.cache_path;
+    job->previous_hash = state.output_hash;
+    job->desktop_entries = std::move(state.desktop_entries);
+    job->history = std::move(state.history);
+    job->history_generation = state.history_generation;
+    job->source_mtime = state.source_mtime;
+
+    GTask* task = g_task_new(nullptr, cancellable_, onGeneratorFinished, nullptr);
+    g_task_set_task_data(task, job, [](gpointer data) { delete static_cast<GeneratorJob*>(data); });
+    g_task_run_in_thread(task, generatorThread);
+    g_object_unref(task);
+}
+
+bool SourceManager::runSource(GeneratorJob& job) {
+    bool success = false;
+    switch (job.source.type) {
+        case SourceType::SSH_HOSTS:
+            success = generateSshHosts(job.group_name, job.group_icon, job.source, job.actions);
+            break;
+        case SourceType::SYSTEMD_UNITS:
+            success = generateSystemdUnits(job.group_name, job.group_icon, job.source, job.actions);
+            break;
+        case SourceType::DIRECTORIES:
+            success = generateDirectories(job.group_name, job.group_icon, job.source, job.actions);
+            break;
+        case SourceType::SCRIPT:
+            success = generateFromScript(job.group_name, job.group_icon, job.source, job.actions);
+            break;
+        case SourceType::DESKTOP_ENTRIES:
+            success = generateDesktopEntries(job.group_name, job.group_icon, job.source, job.desktop_entries, job.actions);
+            break;
+        case SourceType::SHELL_HISTORY:
+            success = generateShellHistory(job.group_name, job.group_icon, job.source, job.history,
+                                           job.history_generation, job.unchanged, job.actions);
+            break;
+        case SourceType::BOOKMARKS:
+            success = generateBookmarks(job.group_name, job.group_icon, job.source, job.source_mtime, job.unchanged,
+                                        job.actions);
+            break;
+    }
+
+    if (!success) {
+        return false;
+    }
+    if (job.unchanged) {
+        return true;
+    }
+
+    // An item that repeats, like a host in two Include files or a repeated script line,
+    // gives the same id twice; the first one wins, as ssh keeps the first value it reads
+    std::unordered_set<std::string> ids;
+    job.actions.erase(std::remove_if(job.actions.begin(), job.actions.end(),
+                                     [&ids](const Action& action) { return !ids.insert(action.id).second; }),
+                      job.actions.end());
+
+    std::string serialized = serializeActions(job.actions);
+    job.output_hash = std::hash<std::string>{}(serialized);
+    job.changed = job.output_hash != job.previous_hash;
+
+    if (job.changed) {
+        gchar* cache_dir = g_path_get_dirname(job.cache_path.c_str());
+        g_mkdir_with_parents(cache_dir, 0755);
+        g_free(cache_dir);
+
+        GError* error = nullptr;
+        if (!g_file_set_contents(job.cache_path.c_str(), serialized.c_str(), serialized.size(), &error)) {
+            LOG_WARNING("Failed to write source cache: " + std::string(error ? error->message : "Unknown error"));
+            if (error) g_error_free(error);
+        }
+    }
+
+    return true;
+}
+
+bool SourceManager::loadCache(const std::string& path, std::vector<Action>& actions) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = splitTabs(line);
+        if (fields.size() < 7) {
+            continue;
+        }
+
+        Action action(fields[0], fields[1], fields[2], fields[3],
+                      static_cast<ActionType>(std::atoi(fields[4].c_str())), fields[5]);
+        action.keywords = splitWhitespace(fields[6]);
+        action.expand_placeholders = false;
+        actions.push_back(action);
+    }
+
+    return true;
+}
+
+// One action per line: id, name, description, icon, type, command and space separated keywords
+std::string SourceManager::serializeActions(const std::vector<Action>& actions) {
+    std::string result;
+    for (const auto& action : actions) {
+        result += action.id + "\t" + action.name + "\t" + action.description + "\t" + action.icon + "\t"
+                + std::to_string(static_cast<int>(action.type)) + "\t" + action.command + "\t";
+        for (size_t k = 0; k < action.keywords.size(); ++k) {
+            if (k > 0) result += " ";
+            result += action.keywords[k];
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+void SourceManager::generatorThread(GTask* task, gpointer source_object, gpointer task_data, GCancellable* cancellable) {
+    auto* job = static_cast<GeneratorJob*>(task_data);
+    g_task_return_boolean(task, runSource(*job));
+}
+
+void SourceManager::onGeneratorFinished(GObject* source_object, GAsyncResult* result, gpointer user_data) {
+    GTask* task = G_TASK(result);
+    if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+        return; // The manager is gone
+    }
+
+    auto* job = static_cast<GeneratorJob*>(g_task_get_task_data(task));
+    SourceState& state = *job->state;
+    state.running = false;
+    state.desktop_entries = std::move(job->desktop_entries);
+    state.history = std::move(job->history);
+    state.history_generation = job->history_generation;
+    state.source_mtime = job->source_mtime;
+
+    if (!g_task_propagate_boolean(task, nullptr)) {
+        LOG_WARNING("Action source '" + state.group_name + "' failed, keeping previous actions");
+    } else if (job->changed) {
+        state.output_hash = job->output_hash;
+        LOG_INFO("Action source '" + state.group_name + "' generated " + std::to_string(job->actions.size()) + " actions");
+        state.manager->mergeActions(state, std::move(job->actions));
+    } else {
+        LOG_DEBUG("Action source '" + state.group_name + "' unchanged");
+    }
+
+    if (state.pending) {
+        state.manager->scheduleRefresh(state);
+    }
+}
+
+gboolean SourceManager::onRefreshTimer(gpointer user_data) {
+    auto* state = static_cast<SourceState*>(user_data);
+    state->manager->scheduleRefresh(*state);
+    return G_SOURCE_CONTINUE;
+}
+
+void SourceManager::onSourceChanged(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                                    GFileMonitorEvent event_type, gpointer user_data) {
+    if (event_type == G_FILE_MONITOR_EVENT_CHANGED) {
+        return; // Wait for CHANGES_DONE_HINT instead of reacting to every write
+    }
+
+    auto* state = static_cast<SourceState*>(user_data);
+    LOG_DEBUG("Source path changed for: " + state->group_name);
+    state->manager->scheduleRefresh(*state);
+}
+
+} // namespace PrimeCuts
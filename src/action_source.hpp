@@ -0,0 +1,85 @@
+#pragma once
+
+#include "config.hpp"
+#include "command_manager.hpp"
+#include "desktop_entry.hpp"
+#include "shell_history.hpp"
+#include <gio/gio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Runs the generators of all groups with a "source" off the main loop and merges
+// their output into the CommandManager. Queries keep seeing the previous actions
+// until a generator has finished, and the last good output is cached on disk.
+class SourceManager {
+public:
+    SourceManager(CommandManager& command_manager, const Config& config);
+    ~SourceManager();
+
+    // Delete copy constructor and assignment operator
+    SourceManager(const SourceManager&) = delete;
+    SourceManager& operator=(const SourceManager&) = delete;
+
+    void start();
+    void refreshAll();
+
+private:
+    struct SourceState {
+        SourceManager* manager = nullptr;
+        std::string group_name;
+        std::string group_icon;
+        ActionSource source;
+        std::vector<Action> static_actions;
+        std::string cache_path;
+        size_t output_hash = 0;
+        DesktopEntryCache desktop_entries; // Handed to the running generator and back
+        ShellHistory history;              // Same
+        uint64_t history_generation = 0;   // Of the history the current actions were built from
+        int64_t source_mtime = 0;          // Of the file read by the last successful run
+        std::vector<GFileMonitor*> monitors;
+        guint timer_id = 0;
+        bool running = false;
+        bool pending = false;
+    };
+
+    struct GeneratorJob {
+        SourceState* state = nullptr;
+        std::string group_name;
+        std::string group_icon;
+        ActionSource source;
+        std::string cache_path;
+        size_t previous_hash = 0;
+        size_t output_hash = 0;
+        bool changed = false;
+        DesktopEntryCache desktop_entries;
+        ShellHistory history;
+        uint64_t history_generation = 0;
+        int64_t source_mtime = 0;
+        bool unchanged = false; // The generator skipped work because its input did not change
+        std::vector<Action> actions;
+    };
+
+    CommandManager& command_manager_;
+    std::vector<std::unique_ptr<SourceState>> sources_;
+    GCancellable* cancellable_;
+
+    void loadCachedActions(SourceState& state);
+    void mergeActions(SourceState& state, std::vector<Action> generated);
+    void watchSource(SourceState& state);
+    void scheduleRefresh(SourceState& state);
+
+    static bool runSource(GeneratorJob& job);
+    static bool loadCache(const std::string& path, std::vector<Action>& actions);
+    static std::string serializeActions(const std::vector<Action>& actions);
+
+    static void generatorThread(GTask* task, gpointer source_object, gpointer task_data, GCancellable* cancellable);
+    static void onGeneratorFinished(GObject* source_object, GAsyncResult* result, gpointer user_data);
+    static gboolean onRefreshTimer(gpointer user_data);
+    static void onSourceChanged(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                                GFileMonitorEvent event_type, gpointer user_data);
+};
+
+} // namespace PrimeCuts
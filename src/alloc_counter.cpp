@@ -0,0 +1,95 @@
+#include "alloc_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<size_t> allocation_count{0};
+std::atomic<size_t> allocation_bytes{0};
+
+void* countedAlloc(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* countedAlignedAlloc(size_t size, std::align_val_t alignment) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+}
+
+} // anonymous namespace
+
+namespace PrimeCuts {
+
+bool AllocationCounter::enabled() {
+    return true;
+}
+
+void AllocationCounter::start() {
+    allocation_count.store(0, std::memory_order_relaxed);
+    allocation_bytes.store(0, std::memory_order_relaxed);
+    counting.store(true, std::memory_order_seq_cst);
+}
+
+AllocationStats AllocationCounter::stop() {
+    counting.store(false, std::memory_order_seq_cst);
+    AllocationStats stats;
+    stats.allocations = allocation_count.load(std::memory_order_relaxed);
+    stats.bytes = allocation_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace PrimeCuts
+
+void* operator new(size_t size) {
+    void* ptr = countedAlloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    void* ptr = countedAlloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* ptr = countedAlignedAlloc(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* ptr = countedAlignedAlloc(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
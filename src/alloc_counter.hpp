@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace PrimeCuts {
+
+struct AllocationStats {
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+// Counts C++ heap allocations (global operator new) made by any thread between
+// start() and stop(). Outside a measurement the replaced operators only pay for
+// one relaxed atomic load. GLib's own allocations (g_malloc, GVariant) bypass
+// operator new and are never counted.
+//
+// Only the primecuts-alloc-counter test build links alloc_counter.cpp, which
+// replaces operator new. The daemon links alloc_counter_disabled.cpp, where
+// enabled() is false and start() and stop() count nothing.
+namespace AllocationCounter {
+    bool enabled();
+    void start();
+    AllocationStats stop();
+}
+
+} // namespace PrimeCuts
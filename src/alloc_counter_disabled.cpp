@@ -0,0 +1,18 @@
+#include "alloc_counter.hpp"
+
+namespace PrimeCuts {
+
+// The daemon keeps the standard operator new; see alloc_counter.hpp
+
+bool AllocationCounter::enabled() {
+    return false;
+}
+
+void AllocationCounter::start() {
+}
+
+AllocationStats AllocationCounter::stop() {
+    return AllocationStats();
+}
+
+} // namespace PrimeCuts
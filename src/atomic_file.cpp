@@ -0,0 +1,112 @@
+#include "atomic_file.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PrimeCuts {
+
+AtomicFile::AtomicFile(const std::string& path)
+    : path_(path) {
+    // Replace the file a symlink points to, not the symlink itself
+    struct stat st;
+    char resolved[PATH_MAX];
+    if (lstat(path.c_str(), &st) == 0 && S_ISLNK(st.st_mode) && realpath(path.c_str(), resolved)) {
+        path_ = resolved;
+    }
+}
+
+AtomicFile::~AtomicFile() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    if (!committed_ && !temp_path_.empty()) {
+        unlink(temp_path_.c_str());
+    }
+}
+
+bool AtomicFile::open() {
+    std::string temp_template = path_ + ".XXXXXX";
+    fd_ = mkostemp(temp_template.data(), O_CLOEXEC);
+    if (fd_ < 0) {
+        return fail("Cannot create a temporary file next to " + path_);
+    }
+    temp_path_ = temp_template;
+
+    // mkstemp creates the file as 0600, keep the mode of the file being replaced
+    struct stat st;
+    mode_t mode = stat(path_.c_str(), &st) == 0 ? (st.st_mode & 07777) : 0644;
+    fchmod(fd_, mode);
+
+    buffer_.reserve(BUFFER_BYTES);
+    return true;
+}
+
+void AtomicFile::write(std::string_view data) {
+    if (fd_ < 0 || !error_.empty()) {
+        return;
+    }
+    if (buffer_.size() + data.size() > BUFFER_BYTES && !flush()) {
+        return;
+    }
+    buffer_.append(data);
+}
+
+bool AtomicFile::flush() {
+    size_t written = 0;
+    while (written < buffer_.size()) {
+        ssize_t result = ::write(fd_, buffer_.data() + written, buffer_.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return fail("Cannot write " + temp_path_);
+        }
+        written += static_cast<size_t>(result);
+    }
+    buffer_.clear();
+    return true;
+}
+
+bool AtomicFile::commit() {
+    if (fd_ < 0) {
+        return error_.empty() ? fail("File was not opened: " + path_) : false;
+    }
+    if (!error_.empty() || !flush()) {
+        return false;
+    }
+    if (fsync(fd_) != 0) {
+        return fail("Cannot sync " + temp_path_);
+    }
+    if (close(fd_) != 0) {
+        fd_ = -1;
+        return fail("Cannot close " + temp_path_);
+    }
+    fd_ = -1;
+
+    if (rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        return fail("Cannot replace " + path_);
+    }
+    committed_ = true;
+
+    // Make the rename itself durable
+    size_t slash = path_.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return true;
+}
+
+bool AtomicFile::fail(const std::string& what) {
+    if (error_.empty()) {
+        error_ = what + ": " + std::strerror(errno);
+    }
+    return false;
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace PrimeCuts {
+
+// Replaces a file without ever exposing a partly written one: the content goes to a
+// temporary file in the same directory, which is synced and renamed over the target.
+// Readers and file monitors see either the old or the complete new file.
+class AtomicFile {
+public:
+    static constexpr size_t BUFFER_BYTES = 64 * 1024;
+
+    explicit AtomicFile(const std::string& path);
+    // Removes the temporary file unless commit() succeeded
+    ~AtomicFile();
+
+    // Delete copy constructor and assignment operator
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    bool open();
+    // Buffered; a failed write is reported by commit()
+    void write(std::string_view data);
+    bool commit();
+
+    const std::string& error() const { return error_; }
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::string buffer_;
+    std::string error_;
+    int fd_ = -1;
+    bool committed_ = false;
+
+    bool flush();
+    bool fail(const std::string& what);
+};
+
+} // namespace PrimeCuts
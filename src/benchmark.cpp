@@ -0,0 +1,176 @@
+#include "benchmark.hpp"
+#include "search_index.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace PrimeCuts {
+
+namespace {
+
+const size_t BENCHMARK_ROUNDS = 5;
+const size_t SYNTHETIC_GROUPS = 64;
+const size_t SYNTHETIC_VOCABULARY = 4096;
+
+std::vector<std::string> buildVocabulary() {
+    static const char* const syllables[] = {
+        "ka", "to", "ri", "mon", "del", "sta", "ge", "pro", "ser", "vi", "ne", "lo",
+        "dat", "ba", "se", "cli", "ent", "net", "work", "git", "hub", "dev", "ops", "ing"
+    };
+    const size_t syllable_count = sizeof(syllables) / sizeof(syllables[0]);
+
+    std::mt19937 rng(42);
+    std::vector<std::string> words;
+    words.reserve(SYNTHETIC_VOCABULARY);
+    while (words.size() < SYNTHETIC_VOCABULARY) {
+        std::string word;
+        size_t parts = 2 + rng() % 3;
+        for (size_t i = 0; i < parts; ++i) {
+            word += syllables[rng() % syllable_count];
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(fraction * (samples.size() - 1));
+    return samples[index];
+}
+
+} // anonymous namespace
+
+Config buildSyntheticConfig(size_t action_count) {
+    std::vector<std::string> words = buildVocabulary();
+    std::mt19937 rng(7);
+    auto word = [&]() -> const std::string& { return words[rng() % words.size()]; };
+
+    Config config;
+    size_t group_count = std::min(SYNTHETIC_GROUPS, std::max<size_t>(action_count / 16, 1));
+    for (size_t g = 0; g < group_count; ++g) {
+        config.groups.emplace_back("Group " + word(), "Generated group", "folder");
+    }
+
+    for (size_t n = 0; n < action_count; ++n) {
+        std::string name = word() + " " + word();
+        name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+        Action action("bench_" + std::to_string(n), name,
+                      "Run " + word() + " on " + word() + " via " + word(),
+                      "system-run", ActionType::TERMINAL_COMMAND, "echo " + word(),
+                      {word(), word(), word()});
+        config.groups[n % group_count].actions.push_back(action);
+    }
+    return config;
+}
+
+std::vector<std::vector<std::string>> buildSyntheticQueries() {
+    std::vector<std::string> words = buildVocabulary();
+    return {
+        {"k"}, {"s"}, {"de"}, {"pro"}, {"serv"},
+        {words[1]}, {words[17].substr(0, 4)}, {words[99]},
+        {words[3], words[250]}, {words[5].substr(0, 3), words[8].substr(0, 3)},
+        {"restart", "nginx"}, {"zzzz"}
+    };
+}
+
+int runShardBenchmark(size_t action_count) {
+    std::cout << "Building synthetic config with " << action_count << " actions..." << std::endl;
+    Config config = buildSyntheticConfig(action_count);
+    std::vector<std::vector<std::string>> queries = buildSyntheticQueries();
+
+    SearchIndex index;
+    auto build_start = std::chrono::steady_clock::now();
+    index.build(config);
+    auto build_end = std::chrono::steady_clock::now();
+    std::cout << "Index built in "
+              << std::chrono::duration<double, std::milli>(build_end - build_start).count() << " ms" << std::endl;
+    std::cout << "Index memory: " << std::fixed << std::setprecision(1) << index.memoryUsage() / (1024.0 * 1024.0)
+              << " MB, " << static_cast<double>(index.memoryUsage()) / std::max<size_t>(index.size(), 1)
+              << " bytes per action (" << static_cast<double>(index.postingMemoryUsage()) / std::max<size_t>(index.size(), 1)
+              << " in trigram postings)" << std::endl;
+
+    // A changed group only re-indexes its own segment
+    auto rebuild_start = std::chrono::steady_clock::now();
+    index.rebuildGroup(0, config.groups[0]);
+    auto rebuild_end = std::chrono::steady_clock::now();
+    std::cout << "Group of " << config.groups[0].actions.size() << " actions re-indexed in "
+              << std::chrono::duration<double, std::milli>(rebuild_end - rebuild_start).count() << " ms" << std::endl;
+
+    std::vector<std::vector<std::string>> folded_queries;
+    for (const auto& query : queries) {
+        std::vector<std::string> folded;
+        for (const auto& term : query) {
+            folded.push_back(SearchIndex::fold(term));
+        }
+        folded_queries.push_back(folded);
+    }
+
+    size_t max_shards = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+    std::vector<size_t> shard_counts;
+    for (size_t shards = 1; shards < max_shards; shards *= 2) {
+        shard_counts.push_back(shards);
+    }
+    shard_counts.push_back(max_shards);
+
+    std::vector<std::vector<uint32_t>> reference;
+    double sequential_mean = 0.0;
+    bool identical = true;
+
+    std::cout << std::left << std::setw(8) << "shards" << std::setw(12) << "mean ms"
+              << std::setw(12) << "p95 ms" << std::setw(12) << "max ms" << "speedup" << std::endl;
+
+    for (size_t shards : shard_counts) {
+        index.setShardCount(shards);
+
+        std::vector<double> samples;
+        for (size_t q = 0; q < folded_queries.size(); ++q) {
+            for (size_t round = 0; round < BENCHMARK_ROUNDS; ++round) {
+                auto start = std::chrono::steady_clock::now();
+                SearchHits hits = index.search(folded_queries[q], 0);
+                auto end = std::chrono::steady_clock::now();
+                samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+                if (round > 0) {
+                    continue;
+                }
+                std::vector<uint32_t> ordinals;
+                for (const auto& hit : hits) {
+                    ordinals.push_back(hit.ordinal);
+                }
+                if (shards == 1) {
+                    reference.push_back(ordinals);
+                } else if (ordinals != reference[q]) {
+                    identical = false;
+                    LOG_ERROR("Results with " + std::to_string(shards) + " shards differ for query " + std::to_string(q));
+                }
+            }
+        }
+
+        double mean = 0.0;
+        for (double sample : samples) {
+            mean += sample;
+        }
+        mean /= samples.size();
+        if (shards == 1) {
+            sequential_mean = mean;
+        }
+
+        std::cout << std::left << std::setw(8) << shards << std::fixed << std::setprecision(3)
+                  << std::setw(12) << mean << std::setw(12) << percentile(samples, 0.95)
+                  << std::setw(12) << percentile(samples, 1.0)
+                  << std::setprecision(2) << sequential_mean / mean << "x" << std::endl;
+    }
+
+    std::cout << (identical ? "All shard counts returned identical results" : "Shard results differ!") << std::endl;
+    return identical ? 0 : 1;
+}
+
+} // namespace PrimeCuts
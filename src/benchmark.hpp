@@ -0,0 +1,20 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Deterministic config with action_count generated actions spread over several groups
+Config buildSyntheticConfig(size_t action_count);
+
+// Typical keystroke queries (single letters, prefixes, multi-word) for a synthetic config
+std::vector<std::vector<std::string>> buildSyntheticQueries();
+
+// Measures search latency with 1 .. hardware_concurrency shards and checks that
+// every shard count returns the same results as the sequential scan
+int runShardBenchmark(size_t action_count);
+
+} // namespace PrimeCuts
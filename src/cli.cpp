@@ -0,0 +1,228 @@
+#include "cli.hpp"
+#include "alloc_counter.hpp"
+#include "command_manager.hpp"
+#include "config_loader.hpp"
+#include "icon_cache.hpp"
+#include "logger.hpp"
+#include "request_arena.hpp"
+#include "result_metas.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace PrimeCuts {
+
+namespace {
+
+// Whitespace-separated terms as views into query, like the borrowed terms of a D-Bus call
+std::vector<std::string_view> splitQuery(const std::string& query) {
+    std::vector<std::string_view> terms;
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t start = query.find_first_not_of(" \t", pos);
+        if (start == std::string::npos) {
+            break;
+        }
+        size_t end = std::min(query.find_first_of(" \t", start), query.size());
+        terms.emplace_back(query.data() + start, end - start);
+        pos = end;
+    }
+    return terms;
+}
+
+// GetResultMetas parameters for a result set, as the shell sends them
+GVariant* metaParameters(const ResultIds& ids) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
+    for (const auto& id : ids) {
+        g_variant_builder_add(&builder, "s", id.c_str());
+    }
+    return g_variant_ref_sink(g_variant_new("(as)", &builder));
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[static_cast<size_t>(fraction * (sorted.size() - 1))];
+}
+
+int runQuery(CommandManager& manager, const HeadlessOptions& options) {
+    std::vector<std::string_view> terms = splitQuery(options.query);
+
+    auto start = std::chrono::steady_clock::now();
+    ResultIds ids = manager.searchActions(terms);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << ids.size() << " results in "
+              << std::chrono::duration<double, std::micro>(end - start).count() << " us" << std::endl;
+
+    const CommandManager& const_manager = manager;
+    Action scratch;
+    for (const auto& id : ids) {
+        std::cout << "  " << id;
+        if (options.with_metas) {
+            const Action* action = const_manager.resolveAction(id, scratch);
+            if (action) {
+                std::cout << "\t" << action->name << "\t" << action->description << "\t" << action->icon;
+            }
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+int runBatch(CommandManager& manager, const MetaSources& meta_sources, const HeadlessOptions& options) {
+    std::ifstream file(options.batch_file);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot open batch file: " + options.batch_file);
+        return 1;
+    }
+
+    std::vector<std::string> queries;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            queries.push_back(line);
+        }
+    }
+
+    const bool counting = AllocationCounter::enabled();
+    if (options.check_allocations && !counting) {
+        LOG_ERROR("This build does not count allocations, run --alloc-budget with primecuts-alloc-counter");
+        return 1;
+    }
+
+    const size_t iterations = std::max<size_t>(options.iterations, 1);
+    std::cout << queries.size() << " queries x " << iterations << " iterations"
+              << (options.with_metas ? " (search + metas)" : "") << std::endl;
+    if (counting) {
+        std::cout << "Allocations count C++ operator new only; GLib allocations, like the GVariants of a reply, are not included" << std::endl;
+    }
+    std::cout << std::left << std::setw(28) << "query" << std::right
+              << std::setw(8) << "results" << std::setw(10) << "min us" << std::setw(10) << "p50 us"
+              << std::setw(10) << "p95 us" << std::setw(10) << "max us" << std::setw(10) << "mean us";
+    if (counting) {
+        std::cout << std::setw(10) << "allocs" << std::setw(12) << "bytes";
+        if (options.with_metas) {
+            std::cout << std::setw(12) << "meta allocs" << std::setw(12) << "meta bytes";
+        }
+    }
+    std::cout << std::endl;
+
+    double total_us = 0.0;
+    size_t over_budget = 0;
+    for (const auto& query : queries) {
+        std::vector<std::string_view> terms = splitQuery(query);
+
+        // Warm-up run, also gives the result count
+        size_t result_count = manager.searchActions(terms).size();
+
+        // Like the D-Bus handlers, each run allocates from the request arena
+        RequestArena& arena = RequestArena::forThread();
+
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        AllocationStats allocations;
+        AllocationStats meta_allocations;
+        size_t worst_allocations = 0;
+        for (size_t i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            AllocationCounter::start();
+            {
+                RequestArena::Scope request;
+                ResultIds ids = manager.searchActions(terms, arena.resource());
+                AllocationStats run = AllocationCounter::stop();
+                allocations.allocations += run.allocations;
+                allocations.bytes += run.bytes;
+                worst_allocations = std::max(worst_allocations, run.allocations);
+                if (options.with_metas) {
+                    // The same handler as the D-Bus call; only the reply is built by GLib
+                    GVariant* parameters = metaParameters(ids);
+                    AllocationCounter::start();
+                    GVariant* reply = g_variant_ref_sink(buildResultMetas(parameters, meta_sources));
+                    AllocationStats meta_run = AllocationCounter::stop();
+                    g_variant_unref(reply);
+                    g_variant_unref(parameters);
+                    meta_allocations.allocations += meta_run.allocations;
+                    meta_allocations.bytes += meta_run.bytes;
+                    worst_allocations = std::max(worst_allocations, meta_run.allocations);
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for (double sample : samples) {
+            mean += sample;
+        }
+        total_us += mean;
+        mean /= samples.size();
+
+        std::string label = query.size() > 26 ? query.substr(0, 23) + "..." : query;
+        std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << result_count << std::setw(10) << samples.front()
+                  << std::setw(10) << percentile(samples, 0.5) << std::setw(10) << percentile(samples, 0.95)
+                  << std::setw(10) << samples.back() << std::setw(10) << mean;
+        if (counting) {
+            std::cout << std::setw(10) << allocations.allocations / iterations
+                      << std::setw(12) << allocations.bytes / iterations;
+            if (options.with_metas) {
+                std::cout << std::setw(12) << meta_allocations.allocations / iterations
+                          << std::setw(12) << meta_allocations.bytes / iterations;
+            }
+        }
+        std::cout << std::endl;
+
+        if (options.check_allocations && worst_allocations > options.alloc_budget) {
+            LOG_ERROR("Query '" + query + "' allocated " + std::to_string(worst_allocations) +
+                      " times in one request, budget is " + std::to_string(options.alloc_budget));
+            over_budget++;
+        }
+    }
+
+    std::cout << "Total search time: " << std::fixed << std::setprecision(1) << total_us / 1000.0 << " ms" << std::endl;
+    if (options.check_allocations) {
+        std::cout << "Allocation budget of " << options.alloc_budget << " C++ allocations per request: "
+                  << (over_budget == 0 ? "passed" : std::to_string(over_budget) + " queries over budget") << std::endl;
+    }
+    return over_budget == 0 ? 0 : 1;
+}
+
+} // anonymous namespace
+
+int runHeadless(const HeadlessOptions& options) {
+    Config config;
+    ConfigLoader loader;
+    if (!loader.loadConfig(options.config_path, config)) {
+        LOG_ERROR("Failed to load configuration");
+        return 1;
+    }
+
+    auto build_start = std::chrono::steady_clock::now();
+    CommandManager manager(config);
+    auto build_end = std::chrono::steady_clock::now();
+    LOG_INFO("Search index built in " + std::to_string(
+        std::chrono::duration<double, std::milli>(build_end - build_start).count()) + " ms");
+    const SearchIndex& index = manager.searchIndex();
+    LOG_INFO("Search index uses " + std::to_string(index.memoryUsage() / 1024) + " KiB, " +
+             std::to_string(index.memoryUsage() / std::max<size_t>(index.size(), 1)) + " bytes per action");
+
+    if (!options.batch_file.empty()) {
+        IconCache icons;
+        MetaSources meta_sources;
+        if (options.with_metas) {
+            icons.prepare(manager.config());
+            meta_sources.manager = &manager;
+            meta_sources.icons = &icons;
+        }
+        return runBatch(manager, meta_sources, options);
+    }
+    return runQuery(manager, options);
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace PrimeCuts {
+
+struct HeadlessOptions {
+    std::string config_path;  // Empty = default config location
+    std::string query;        // --query: run one search and print the results
+    std::string batch_file;   // --batch: newline-separated queries to profile
+    size_t iterations = 100;  // Runs per batch query
+    bool with_metas = false;  // Also build the result metas with the GetResultMetas handler
+    size_t alloc_budget = 0;  // --alloc-budget: fail if a warm search or metas request allocates more often; 0 = no check
+    bool check_allocations = false;
+};
+
+// Runs searches against the loaded config without D-Bus, for profiling with perf or heaptrack.
+// Returns non-zero when a batch query exceeds the allocation budget.
+int runHeadless(const HeadlessOptions& options);
+
+} // namespace PrimeCuts
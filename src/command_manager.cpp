@@ -7,6 +7,7 @@
 #include <sstream>
 #include <cctype>
 #include <cstdio>
+#include <utility>
 
 namespace PrimeCuts {
 
@@ -15,6 +16,7 @@ CommandManager::CommandManager(const Config& config) : config_(config) {
 }
 
 void CommandManager::updateConfig(const Config& config) {
+    std::unique_lock<std::shared_mutex> lock(change_mutex_);
     config_ = config;
     rebuildActionMap();
 }
@@ -23,169 +25,283 @@ void CommandManager::rebuildActionMap() {
     action_map_.clear();
     for (auto& group : config_.groups) {
         for (auto& action : group.actions) {
-            action_map_[action.id] = &action;
+            registerAction(action);
         }
     }
+    
+    applySearchSettings();
+    search_index_.build(config_);
 }
 
-std::vector<Action> CommandManager::getAllActions() const {
-    std::vector<Action> actions;
-    for (const auto& group : config_.groups) {
-        for (const auto& action : group.actions) {
-            actions.push_back(action);
-        }
+void CommandManager::registerAction(Action& action) {
+    action_map_[action.id] = &action;
+    
+    // Placeholders are parsed here once, activation only fills them in
+    if (!action.expand_placeholders) {
+        action.command_template = CommandTemplate();
+        return;
     }
-    return actions;
+    CommandTemplate::Escaping escaping = action.type == ActionType::URL
+        ? CommandTemplate::Escaping::URL
+        : CommandTemplate::Escaping::SHELL;
+    action.command_template = CommandTemplate::compile(action.command, escaping);
 }
 
-std::vector<std::string> CommandManager::searchActions(const std::vector<std::string>& terms) const {
-    // Store search terms for virtual actions
-    current_search_terms_ = terms;
+void CommandManager::applySearchSettings() {
+    max_results_ = getNumericSetting(Constants::SETTING_MAX_RESULTS, 0);
     
-    std::vector<std::string> matches;
-    
-    std::stringstream debug_msg;
-    debug_msg << "Searching with " << terms.size() << " terms: ";
-    for (const auto& term : terms) {
-        debug_msg << "'" << term << "' ";
+    MatchMode match_mode = MatchMode::ANY;
+    auto mode_it = config_.global_settings.find(Constants::SETTING_MATCH_MODE);
+    if (mode_it != config_.global_settings.end() && !SearchIndex::parseMatchMode(mode_it->second, match_mode)) {
+        LOG_WARNING("Unknown match_mode '" + mode_it->second + "', using 'any'");
     }
-    LOG_DEBUG(debug_msg.str());
+    search_index_.setMatchMode(match_mode);
+    search_index_.setTimeBudget(std::chrono::milliseconds(getNumericSetting(Constants::SETTING_SEARCH_BUDGET_MS, 0)));
     
-    // Search regular actions
-    for (const auto& group : config_.groups) {
-        for (const auto& action : group.actions) {
-            if (matchesTerms(action, terms)) {
-                matches.push_back(action.id);
-                LOG_DEBUG("Action matched: " + action.name + " (ID: " + action.id + ")");
-            }
-        }
+    size_t shards = std::max<size_t>(getNumericSetting(Constants::SETTING_SEARCH_SHARDS, 1), 1);
+    if (shards != search_index_.shardCount()) {
+        search_index_.setShardCount(shards);
+        LOG_DEBUG("Search index uses " + std::to_string(shards) + " shards");
     }
-    
-    // Add virtual search actions if there are search terms
-    if (!terms.empty()) {
-        matches.push_back(Constants::SEARCH_GOOGLE_ID);
-        matches.push_back(Constants::SEARCH_CHATGPT_ID);
-        LOG_DEBUG("Added virtual search actions for: " + joinTerms(terms));
+}
+
+size_t CommandManager::getNumericSetting(const char* key, size_t default_value) const {
+    auto it = config_.global_settings.find(key);
+    if (it == config_.global_settings.end() || it->second.empty()) {
+        return default_value;
     }
-    
-    LOG_DEBUG("Total matches found: " + std::to_string(matches.size()));
-    return matches;
+    return static_cast<size_t>(strtoul(it->second.c_str(), nullptr, 10));
 }
 
-bool CommandManager::matchesTerms(const Action& action, const std::vector<std::string>& terms) const {
-    if (terms.empty()) {
+bool CommandManager::replaceGroupActions(const std::string& group_name, std::vector<Action> actions) {
+    auto group_it = std::find_if(config_.groups.begin(), config_.groups.end(),
+                                 [&](const Group& group) { return group.name == group_name; });
+    if (group_it == config_.groups.end()) {
+        LOG_WARNING("Cannot update actions of unknown group: " + group_name);
         return false;
     }
     
-    // Convert search terms to lowercase for case-insensitive matching
-    std::vector<std::string> lower_terms;
-    for (const auto& term : terms) {
-        std::string lower_term = term;
-        std::transform(lower_term.begin(), lower_term.end(), lower_term.begin(), ::tolower);
-        if (!lower_term.empty()) {
-            lower_terms.push_back(lower_term);
-        }
+    std::unique_lock<std::shared_mutex> lock(change_mutex_);
+    unregisterGroupActions(*group_it);
+    group_it->actions = std::move(actions);
+    for (auto& action : group_it->actions) {
+        registerAction(action);
     }
+    search_index_.rebuildGroup(static_cast<size_t>(group_it - config_.groups.begin()), *group_it);
     
-    if (lower_terms.empty()) {
-        return false;
+    LOG_DEBUG("Group '" + group_name + "' now has " + std::to_string(group_it->actions.size()) + " actions");
+    return true;
+}
+
+size_t CommandManager::applyGroupChanges(const std::vector<std::string>& removed_groups, std::vector<Group> updated_groups) {
+    auto find_group = [this](const std::string& name) {
+        return std::find_if(config_.groups.begin(), config_.groups.end(),
+                            [&](const Group& group) { return group.name == name; });
+    };
+    size_t applied = 0;
+    
+    std::unique_lock<std::shared_mutex> lock(change_mutex_);
+    std::vector<bool> removed(config_.groups.size(), false);
+    for (const auto& name : removed_groups) {
+        auto group_it = find_group(name);
+        if (group_it != config_.groups.end() && !removed[group_it - config_.groups.begin()]) {
+            unregisterGroupActions(*group_it);
+            removed[group_it - config_.groups.begin()] = true;
+            applied++;
+            LOG_DEBUG("Group '" + name + "' removed");
+        }
+    }
+    // Moving a group keeps its actions where they are
+    size_t kept = 0;
+    for (size_t g = 0; g < config_.groups.size(); ++g) {
+        if (!removed[g]) {
+            if (kept != g) {
+                config_.groups[kept] = std::move(config_.groups[g]);
+            }
+            kept++;
+        }
     }
+    config_.groups.resize(kept);
     
-    // Check if any term matches
-    for (const auto& term : lower_terms) {
-        if (matchesSingleTerm(action, term)) {
-            return true;
+    std::vector<size_t> changed;
+    for (auto& group : updated_groups) {
+        auto group_it = find_group(group.name);
+        if (group_it != config_.groups.end()) {
+            unregisterGroupActions(*group_it);
+            *group_it = std::move(group);
+        } else {
+            config_.groups.push_back(std::move(group));
+            group_it = config_.groups.end() - 1;
+        }
+        for (auto& action : group_it->actions) {
+            registerAction(action);
         }
+        changed.push_back(static_cast<size_t>(group_it - config_.groups.begin()));
+        applied++;
+        LOG_DEBUG("Group '" + group_it->name + "' updated with " + std::to_string(group_it->actions.size()) + " actions");
     }
     
-    return false;
+    search_index_.updateGroups(config_, removed, std::move(changed));
+    return applied;
 }
 
-bool CommandManager::matchesSingleTerm(const Action& action, const std::string& lower_term) const {
-    auto toLower = [](const std::string& str) {
-        std::string result = str;
-        std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-        return result;
-    };
-    
-    // Check keywords
-    for (const auto& keyword : action.keywords) {
-        if (toLower(keyword).find(lower_term) != std::string::npos) {
-            LOG_DEBUG("MATCH - Action '" + action.name + "' keyword '" + keyword + "' contains '" + lower_term + "'");
-            return true;
+const Group* CommandManager::findGroup(const std::string& group_name) const {
+    auto group_it = std::find_if(config_.groups.begin(), config_.groups.end(),
+                                 [&](const Group& group) { return group.name == group_name; });
+    return group_it != config_.groups.end() ? &*group_it : nullptr;
+}
+
+// Only the entries of this group are touched, every other pointer stays valid
+void CommandManager::unregisterGroupActions(const Group& group) {
+    for (const auto& action : group.actions) {
+        auto it = action_map_.find(action.id);
+        if (it != action_map_.end() && it->second == &action) {
+            action_map_.erase(it);
         }
     }
+}
+
+std::vector<Action> CommandManager::getAllActions() const {
+    std::vector<Action> actions;
+    for (const auto& group : config_.groups) {
+        for (const auto& action : group.actions) {
+            actions.push_back(action);
+        }
+    }
+    return actions;
+}
+
+SearchHits CommandManager::rankActions(const std::vector<std::string>& folded_terms, std::pmr::memory_resource* memory) const {
+    bool truncated = false;
+    SearchHits hits = search_index_.search(folded_terms, max_results_, &truncated, memory);
+    if (truncated) {
+        LOG_INFO("Search budget exhausted, returning " + std::to_string(hits.size()) + " results found so far");
+    }
+    return hits;
+}
+
+ResultIds CommandManager::searchActions(TermSpan terms, std::pmr::memory_resource* memory) const {
+    ResultIds matches(memory);
     
-    // Check name
-    if (toLower(action.name).find(lower_term) != std::string::npos) {
-        LOG_DEBUG("MATCH - Action '" + action.name + "' name contains '" + lower_term + "'");
-        return true;
+    if (Logger::getInstance().isDebugEnabled()) {
+        std::stringstream debug_msg;
+        debug_msg << "Searching with " << terms.size() << " terms: ";
+        for (const auto& term : terms) {
+            debug_msg << "'" << term << "' ";
+        }
+        LOG_DEBUG(debug_msg.str());
     }
     
-    // Check description
-    if (toLower(action.description).find(lower_term) != std::string::npos) {
-        LOG_DEBUG("MATCH - Action '" + action.name + "' description contains '" + lower_term + "'");
-        return true;
+    // Search regular actions
+    std::vector<std::string> folded_terms;
+    for (const auto& term : terms) {
+        if (!term.empty()) {
+            folded_terms.push_back(SearchIndex::fold(term));
+        }
     }
     
-    // Check ID
-    if (toLower(action.id).find(lower_term) != std::string::npos) {
-        LOG_DEBUG("MATCH - Action '" + action.name + "' ID contains '" + lower_term + "'");
-        return true;
+    SearchHits hits = rankActions(folded_terms, memory);
+    matches.reserve(hits.size() + 2);
+    for (const auto& hit : hits) {
+        matches.emplace_back(hit.action->id);
     }
     
-    return false;
-}
-
-Action* CommandManager::getAction(const std::string& id) {
-    // Handle virtual search actions - we need to return them as mutable for the main.cpp getAction calls
-    // We'll use static storage to provide mutable access
-    if (id == Constants::SEARCH_GOOGLE_ID) {
-        static Action google_action;
-        google_action = createGoogleSearchAction(current_search_terms_);
-        return &google_action;
+    if (Logger::getInstance().isDebugEnabled()) {
+        for (const auto& hit : hits) {
+            LOG_DEBUG("Action matched: " + hit.action->name + " (ID: " + hit.action->id + ", score: " + std::to_string(hit.score) + ")");
+        }
     }
-    if (id == Constants::SEARCH_CHATGPT_ID) {
-        static Action chatgpt_action;
-        chatgpt_action = createChatGPTSearchAction(current_search_terms_);
-        return &chatgpt_action;
+    
+    // Add virtual search actions if there are search terms; their ids name the session
+    // that keeps this query, so metas and activation never depend on a later search.
+    // The slot reuses its string, so holding the lock costs no allocation once warm.
+    if (!terms.empty()) {
+        uint32_t session_id = 0;
+        {
+            std::unique_lock<std::mutex> lock;
+            QuerySession& session = sessions_.acquire(lock);
+            session_id = session.id;
+            session.encoded_query.clear();
+            for (size_t i = 0; i < terms.size(); ++i) {
+                if (i > 0) {
+                    session.encoded_query += '+';
+                }
+                appendUrlEncoded(session.encoded_query, terms[i]);
+            }
+        }
+        
+        matches.emplace_back();
+        QuerySessionSlab::encodeId(Constants::SEARCH_GOOGLE_ID, session_id, matches.back());
+        matches.emplace_back();
+        QuerySessionSlab::encodeId(Constants::SEARCH_CHATGPT_ID, session_id, matches.back());
+        LOG_DEBUG("Added virtual search actions for session " + std::to_string(session_id));
     }
     
+    LOG_DEBUG("Total matches found: " + std::to_string(matches.size()));
+    return matches;
+}
+
+Action* CommandManager::getAction(std::string_view id) {
+    return const_cast<Action*>(std::as_const(*this).getAction(id));
+}
+
+const Action* CommandManager::getAction(std::string_view id) const {
     auto it = action_map_.find(id);
     return (it != action_map_.end()) ? it->second : nullptr;
 }
 
-const Action* CommandManager::getAction(const std::string& id) const {
-    // Handle virtual search actions
+const Action* CommandManager::resolveAction(std::string_view id, Action& scratch) const {
+    if (const Action* action = getAction(id)) {
+        return action;
+    }
+    return findVirtualAction(id, scratch) ? &scratch : nullptr;
+}
+
+bool CommandManager::sessionlessAction(std::string_view id, Action& action) {
     if (id == Constants::SEARCH_GOOGLE_ID) {
-        static Action google_action = createGoogleSearchAction(current_search_terms_);
-        google_action = createGoogleSearchAction(current_search_terms_); // Refresh with current terms
-        return &google_action;
+        action = createGoogleSearchAction("");
+    } else if (id == Constants::SEARCH_CHATGPT_ID) {
+        action = createChatGPTSearchAction("");
+    } else {
+        return false;
     }
-    if (id == Constants::SEARCH_CHATGPT_ID) {
-        static Action chatgpt_action = createChatGPTSearchAction(current_search_terms_);
-        chatgpt_action = createChatGPTSearchAction(current_search_terms_); // Refresh with current terms
-        return &chatgpt_action;
+    return true;
+}
+
+bool CommandManager::findVirtualAction(std::string_view id, Action& action) const {
+    uint32_t session_id = 0;
+    std::string_view base = QuerySessionSlab::decodeId(id, session_id);
+    bool is_google = base == Constants::SEARCH_GOOGLE_ID;
+    if (!is_google && base != Constants::SEARCH_CHATGPT_ID) {
+        return false;
     }
     
-    // Handle regular actions
-    auto it = action_map_.find(id);
-    return (it != action_map_.end()) ? it->second : nullptr;
+    if (session_id == 0) {
+        return sessionlessAction(id, action);
+    }
+    std::string encoded_query;
+    if (!sessions_.read(session_id, [&](const QuerySession& session) { encoded_query = session.encoded_query; })) {
+        LOG_DEBUG("Query session expired for: " + std::string(id));
+        return false;
+    }
+    action = is_google ? createGoogleSearchAction(encoded_query) : createChatGPTSearchAction(encoded_query);
+    action.id = id;
+    return true;
 }
 
-bool CommandManager::executeAction(const std::string& id, const std::vector<std::string>& terms) {
-    // Handle virtual search actions
-    if (id == Constants::SEARCH_GOOGLE_ID) {
-        std::string search_query = joinTerms(!terms.empty() ? terms : current_search_terms_);
-        std::string encoded_query = urlEncode(search_query);
-        std::string url = Constants::GOOGLE_SEARCH_URL + encoded_query;
-        return executeUrl(url);
-    }
-    if (id == Constants::SEARCH_CHATGPT_ID) {
-        std::string search_query = joinTerms(!terms.empty() ? terms : current_search_terms_);
-        std::string encoded_query = urlEncode(search_query);
-        std::string url = Constants::CHATGPT_SEARCH_URL + encoded_query;
-        return executeUrl(url);
+bool CommandManager::executeAction(const std::string& id, TermSpan terms) {
+    // Handle virtual search actions, the session already holds the encoded query
+    uint32_t session_id = 0;
+    std::string_view base = QuerySessionSlab::decodeId(id, session_id);
+    if (base == Constants::SEARCH_GOOGLE_ID || base == Constants::SEARCH_CHATGPT_ID) {
+        std::string encoded_query;
+        if (!sessions_.read(session_id, [&](const QuerySession& session) { encoded_query = session.encoded_query; })) {
+            encoded_query = urlEncode(joinTerms(terms));
+        }
+        const char* search_url = base == Constants::SEARCH_GOOGLE_ID
+            ? Constants::GOOGLE_SEARCH_URL
+            : Constants::CHATGPT_SEARCH_URL;
+        return executeUrl(search_url + encoded_query);
     }
     
     // Handle regular actions
@@ -197,28 +313,86 @@ bool CommandManager::executeAction(const std::string& id, const std::vector<std:
     
     LOG_INFO("Executing action: " + action->name + " (" + action->id + ")");
     
+    const std::string* command = &action->command;
+    if (!action->command_template.empty()) {
+        action->command_template.fill(terms, command_buffer_);
+        command = &command_buffer_;
+    }
+    
+    // Working directory, environment and timeout wrap the command itself, also inside a terminal
+    std::string launch_command;
+    if (!action->extra_params.empty() && action->type != ActionType::URL) {
+        launch_command = applyLaunchParams(action->extra_params, *command);
+        command = &launch_command;
+    }
+    
     switch (action->type) {
         case ActionType::COMMAND:
-            return executeCommand(action->command);
+            return executeCommand(*command);
         case ActionType::TERMINAL_COMMAND:
-            return executeTerminalCommand(action->command);
+            return executeTerminalCommand(*command, action->extra_params.find(Constants::PARAM_TERMINAL_PROFILE));
         case ActionType::URL:
-            return executeUrl(action->command);
+            return executeUrl(*command);
         case ActionType::APPLICATION:
-            return executeCommand(action->command);
+            return executeCommand(*command);
         default:
             LOG_ERROR("Unknown action type for: " + id);
             return false;
     }
 }
 
-std::string CommandManager::buildTerminalCommand(const std::string& command) const {
+std::string CommandManager::applyLaunchParams(const ParamMap& params, const std::string& command) const {
+    std::string launch;
+    if (const std::string* cwd = params.find(Constants::PARAM_CWD)) {
+        launch += "cd ";
+        if (cwd->compare(0, 1, "~") == 0 && (cwd->size() == 1 || (*cwd)[1] == '/')) {
+            launch += "\"$HOME\"";
+            appendShellQuoted(launch, std::string_view(*cwd).substr(1));
+        } else {
+            appendShellQuoted(launch, *cwd);
+        }
+        launch += " || exit 1; ";
+    }
+    
+    params.forEachWithPrefix(Constants::PARAM_ENV_PREFIX, [&](std::string_view name, const std::string& value) {
+        bool valid = !name.empty() && !std::isdigit(static_cast<unsigned char>(name[0])) &&
+            std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+        if (!valid) {
+            LOG_WARNING("Ignoring invalid environment variable name: " + std::string(name));
+            return;
+        }
+        launch += "export ";
+        launch += name;
+        launch += '=';
+        appendShellQuoted(launch, value);
+        launch += "; ";
+    });
+    launch += command;
+    
+    const std::string* timeout = params.find(Constants::PARAM_TIMEOUT);
+    unsigned long seconds = timeout ? strtoul(timeout->c_str(), nullptr, 10) : 0;
+    if (seconds > 0) {
+        std::string limited = "timeout " + std::to_string(seconds) + " sh -c ";
+        appendShellQuoted(limited, launch);
+        return limited;
+    }
+    return launch;
+}
+
+std::string CommandManager::buildTerminalCommand(const std::string& command, const std::string* profile) const {
     auto it = config_.global_settings.find(Constants::SETTING_TERMINAL_COMMAND);
     std::string terminal_cmd = (it != config_.global_settings.end()) 
         ? it->second 
         : Constants::DEFAULT_TERMINAL_COMMAND;
     
-    return terminal_cmd + " -- bash -c '" + command + "; echo \"Press Enter to close...\"; read'";
+    std::string full_command = terminal_cmd;
+    if (profile) {
+        full_command += " --profile=";
+        appendShellQuoted(full_command, *profile);
+    }
+    full_command += " -- bash -c ";
+    appendShellQuoted(full_command, command + "; echo \"Press Enter to close...\"; read");
+    return full_command;
 }
 
 bool CommandManager::executeCommand(const std::string& command) const {
@@ -230,8 +404,8 @@ bool CommandManager::executeCommand(const std::string& command) const {
     return result == 0;
 }
 
-bool CommandManager::executeTerminalCommand(const std::string& command) const {
-    std::string full_command = buildTerminalCommand(command);
+bool CommandManager::executeTerminalCommand(const std::string& command, const std::string* profile) const {
+    std::string full_command = buildTerminalCommand(command, profile);
     LOG_INFO("Executing terminal command: " + command);
     int result = system(full_command.c_str());
     if (result != 0) {
@@ -246,7 +420,8 @@ bool CommandManager::executeUrl(const std::string& url) const {
         ? it->second 
         : Constants::DEFAULT_BROWSER_COMMAND;
     
-    std::string full_command = browser_cmd + " '" + url + "'";
+    std::string full_command = browser_cmd + ' ';
+    appendShellQuoted(full_command, url);
     LOG_INFO("Opening URL: " + url);
     int result = system(full_command.c_str());
     if (result != 0) {
@@ -255,54 +430,42 @@ bool CommandManager::executeUrl(const std::string& url) const {
     return result == 0;
 }
 
-Action CommandManager::createGoogleSearchAction(const std::vector<std::string>& terms) const {
-    std::string search_query = joinTerms(terms);
+Action CommandManager::createGoogleSearchAction(const std::string& encoded_query) {
     return Action(
         Constants::SEARCH_GOOGLE_ID,
         "Google",
         "Ask Google for your query",
         "web-browser",
         ActionType::URL,
-        Constants::GOOGLE_SEARCH_URL + urlEncode(search_query)
+        Constants::GOOGLE_SEARCH_URL + encoded_query
     );
 }
 
-Action CommandManager::createChatGPTSearchAction(const std::vector<std::string>& terms) const {
-    std::string search_query = joinTerms(terms);
+Action CommandManager::createChatGPTSearchAction(const std::string& encoded_query) {
     return Action(
         Constants::SEARCH_CHATGPT_ID,
         "ChatGPT",
         "Ask ChatGPT for your query",
         "web-browser",
         ActionType::URL,
-        Constants::CHATGPT_SEARCH_URL + urlEncode(search_query)
+        Constants::CHATGPT_SEARCH_URL + encoded_query
     );
 }
 
-std::string CommandManager::joinTerms(const std::vector<std::string>& terms) const {
+std::string CommandManager::joinTerms(TermSpan terms) const {
     if (terms.empty()) return "";
     
-    std::string result = terms[0];
+    std::string result(terms[0]);
     for (size_t i = 1; i < terms.size(); ++i) {
-        result += " " + terms[i];
+        result += ' ';
+        result += terms[i];
     }
     return result;
 }
 
 std::string CommandManager::urlEncode(const std::string& str) const {
     std::string encoded;
-    for (char c : str) {
-        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-            encoded += c;
-        } else if (c == ' ') {
-            encoded += '+';
-        } else {
-            encoded += '%';
-            char hex[3];
-            snprintf(hex, sizeof(hex), "%02X", static_cast<unsigned char>(c));
-            encoded += hex;
-        }
-    }
+    appendUrlEncoded(encoded, str);
     return encoded;
 }
 
@@ -1,12 +1,21 @@
 #pragma once
 
 #include "config.hpp"
+#include "search_index.hpp"
+#include "query_session.hpp"
+#include "term_span.hpp"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory_resource>
+#include <shared_mutex>
 
 namespace PrimeCuts {
 
+// Ids of a search result, allocated from the caller's memory resource
+using ResultIds = std::pmr::vector<std::pmr::string>;
+
 class CommandManager {
 public:
     explicit CommandManager(const Config& config);
@@ -16,31 +25,64 @@ public:
     CommandManager(const CommandManager&) = delete;
     CommandManager& operator=(const CommandManager&) = delete;
     
-    std::vector<std::string> searchActions(const std::vector<std::string>& terms) const;
-    Action* getAction(const std::string& id);
-    const Action* getAction(const std::string& id) const;
-    bool executeAction(const std::string& id, const std::vector<std::string>& terms = {});
+    // Pass the request arena as memory to keep the temporaries of a search off the heap
+    ResultIds searchActions(TermSpan terms, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+    // Ranked configured and generated actions, without the virtual search actions
+    SearchHits rankActions(const std::vector<std::string>& folded_terms,
+                           std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+    // Configured and generated actions only
+    Action* getAction(std::string_view id);
+    const Action* getAction(std::string_view id) const;
+    // Also resolves virtual search actions, which are copied into scratch because a
+    // later search may reuse their session
+    const Action* resolveAction(std::string_view id, Action& scratch) const;
+    // Virtual search action of an id without a session, as answered before the index was
+    // ready. Its command lacks the query; executeAction uses the terms it is given.
+    static bool sessionlessAction(std::string_view id, Action& action);
+    bool executeAction(const std::string& id, TermSpan terms = {});
     
     void updateConfig(const Config& config);
+    bool replaceGroupActions(const std::string& group_name, std::vector<Action> actions);
+    // Removes the named groups, then adds each updated group or replaces the group with
+    // the same name. The search index is updated once, re-indexing only the changed groups.
+    // Returns how many groups were removed or updated.
+    size_t applyGroupChanges(const std::vector<std::string>& removed_groups, std::vector<Group> updated_groups);
+    const Group* findGroup(const std::string& group_name) const;
     std::vector<Action> getAllActions() const;
+    const SearchIndex& searchIndex() const { return search_index_; }
+    const Config& config() const { return config_; }
+    uint32_t nextSessionId() const { return sessions_.nextId(); }
+    // Actions and the index only change on the main loop, so reads there need no lock.
+    // Another thread holds this while it reads them; changes wait until it is released.
+    std::shared_lock<std::shared_mutex> lockForReading() const { return std::shared_lock<std::shared_mutex>(change_mutex_); }
+    void resumeSessions(uint32_t next_id) { sessions_.resumeAt(next_id); }
     
 private:
     Config config_;
-    std::map<std::string, Action*> action_map_;
-    mutable std::vector<std::string> current_search_terms_; // Store current search terms for virtual actions
+    std::map<std::string, Action*, std::less<>> action_map_; // Looked up by string_view
+    SearchIndex search_index_;
+    size_t max_results_ = 0;
+    mutable QuerySessionSlab sessions_; // Encoded queries of recent searches
+    std::string command_buffer_; // Filled command templates, reused by every activation
+    mutable std::shared_mutex change_mutex_; // Held exclusively while actions or the index change
     
     void rebuildActionMap();
-    bool matchesTerms(const Action& action, const std::vector<std::string>& terms) const;
-    bool matchesSingleTerm(const Action& action, const std::string& lower_term) const;
-    std::string buildTerminalCommand(const std::string& command) const;
+    void registerAction(Action& action);
+    void unregisterGroupActions(const Group& group);
+    void applySearchSettings();
+    size_t getNumericSetting(const char* key, size_t default_value) const;
+    std::string applyLaunchParams(const ParamMap& params, const std::string& command) const;
+    // profile: terminal profile name from extra_params, nullptr for the default
+    std::string buildTerminalCommand(const std::string& command, const std::string* profile = nullptr) const;
     bool executeCommand(const std::string& command) const;
-    bool executeTerminalCommand(const std::string& command) const;
+    bool executeTerminalCommand(const std::string& command, const std::string* profile = nullptr) const;
     bool executeUrl(const std::string& url) const;
 
     // Virtual search actions
-    Action createGoogleSearchAction(const std::vector<std::string>& terms) const;
-    Action createChatGPTSearchAction(const std::vector<std::string>& terms) const;
-    std::string joinTerms(const std::vector<std::string>& terms) const;
+    bool findVirtualAction(std::string_view id, Action& action) const;
+    static Action createGoogleSearchAction(const std::string& encoded_query);
+    static Action createChatGPTSearchAction(const std::string& encoded_query);
+    std::string joinTerms(TermSpan terms) const;
     std::string urlEncode(const std::string& str) const;
 };
 
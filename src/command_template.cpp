@@ -0,0 +1,208 @@
+#include "command_template.hpp"
+#include <cctype>
+
+namespace PrimeCuts {
+
+namespace {
+
+const std::string_view PLACEHOLDER_QUERY = "query";
+const std::string_view PLACEHOLDER_QUERY_URLENCODED = "query_urlencoded";
+const std::string_view PLACEHOLDER_TERM = "term";
+
+// Body of a single-quoted shell word: a quote ends the word, is escaped and reopens it
+void appendShellBody(std::string& out, std::string_view text) {
+    for (char c : text) {
+        if (c == '\'') {
+            out += "'\\''";
+        } else {
+            out += c;
+        }
+    }
+}
+
+// Body of a double-quoted shell word: only these characters keep a meaning there
+void appendDoubleQuotedBody(std::string& out, std::string_view text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\' || c == '$' || c == '`') {
+            out += '\\';
+        }
+        out += c;
+    }
+}
+
+// Parses "termN" with N >= 1 into a 0-based index
+bool parseTermIndex(std::string_view name, uint32_t& index) {
+    if (name.size() <= PLACEHOLDER_TERM.size() || name.compare(0, PLACEHOLDER_TERM.size(), PLACEHOLDER_TERM) != 0) {
+        return false;
+    }
+    uint32_t number = 0;
+    for (size_t i = PLACEHOLDER_TERM.size(); i < name.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(name[i])) || number > 9999) {
+            return false;
+        }
+        number = number * 10 + static_cast<uint32_t>(name[i] - '0');
+    }
+    if (number == 0) {
+        return false;
+    }
+    index = number - 1;
+    return true;
+}
+
+} // anonymous namespace
+
+void appendShellQuoted(std::string& out, std::string_view text) {
+    out += '\'';
+    appendShellBody(out, text);
+    out += '\'';
+}
+
+void appendUrlEncoded(std::string& out, std::string_view text) {
+    static const char HEX[] = "0123456789ABCDEF";
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += c;
+        } else if (c == ' ') {
+            out += '+';
+        } else {
+            out += '%';
+            out += HEX[byte >> 4];
+            out += HEX[byte & 0x0f];
+        }
+    }
+}
+
+CommandTemplate CommandTemplate::compile(std::string_view command, Escaping escaping) {
+    CommandTemplate compiled;
+    compiled.escaping_ = escaping;
+    bool has_placeholder = false;
+    Quoting quoting = Quoting::NONE;
+
+    size_t literal_start = 0;
+    size_t quoting_start = 0;
+    size_t pos = 0;
+    while ((pos = command.find('{', pos)) != std::string_view::npos) {
+        size_t close = command.find('}', pos + 1);
+        if (close == std::string_view::npos) {
+            break;
+        }
+
+        std::string_view name = command.substr(pos + 1, close - pos - 1);
+        Segment placeholder{Kind::LITERAL, Quoting::NONE, 0, 0};
+        if (name == PLACEHOLDER_QUERY) {
+            placeholder.kind = Kind::QUERY;
+        } else if (name == PLACEHOLDER_QUERY_URLENCODED) {
+            placeholder.kind = Kind::QUERY_URLENCODED;
+        } else if (parseTermIndex(name, placeholder.begin)) {
+            placeholder.kind = Kind::TERM;
+        } else {
+            pos++;
+            continue;
+        }
+
+        if (escaping == Escaping::SHELL) {
+            quoting = advanceQuoting(command.substr(quoting_start, pos - quoting_start), quoting);
+            placeholder.quoting = quoting;
+        }
+        if (pos > literal_start) {
+            compiled.segments_.push_back({Kind::LITERAL, Quoting::NONE, static_cast<uint32_t>(compiled.literals_.size()),
+                                          static_cast<uint32_t>(pos - literal_start)});
+            compiled.literals_.append(command.substr(literal_start, pos - literal_start));
+        }
+        compiled.segments_.push_back(placeholder);
+        has_placeholder = true;
+        pos = close + 1;
+        literal_start = pos;
+        quoting_start = pos;
+    }
+
+    if (!has_placeholder) {
+        return CommandTemplate();
+    }
+    if (literal_start < command.size()) {
+        compiled.segments_.push_back({Kind::LITERAL, Quoting::NONE, static_cast<uint32_t>(compiled.literals_.size()),
+                                      static_cast<uint32_t>(command.size() - literal_start)});
+        compiled.literals_.append(command.substr(literal_start));
+    }
+    return compiled;
+}
+
+void CommandTemplate::fill(TermSpan terms, std::string& out) const {
+    out.clear();
+    for (const auto& segment : segments_) {
+        switch (segment.kind) {
+            case Kind::LITERAL:
+                out.append(literals_, segment.begin, segment.length);
+                break;
+            case Kind::QUERY:
+                appendQuery(out, terms, escaping_, segment.quoting);
+                break;
+            case Kind::TERM: {
+                std::string_view term = segment.begin < terms.size() ? terms[segment.begin] : std::string_view();
+                appendQuery(out, TermSpan(&term, 1), escaping_, segment.quoting);
+                break;
+            }
+            case Kind::QUERY_URLENCODED:
+                appendQuery(out, terms, Escaping::URL, segment.quoting);
+                break;
+        }
+    }
+}
+
+// Follows sh quoting over literal text: quotes open and close, a backslash outside
+// single quotes escapes the next character
+CommandTemplate::Quoting CommandTemplate::advanceQuoting(std::string_view text, Quoting quoting) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        switch (quoting) {
+            case Quoting::NONE:
+                if (c == '\'') {
+                    quoting = Quoting::SINGLE;
+                } else if (c == '"') {
+                    quoting = Quoting::DOUBLE;
+                } else if (c == '\\') {
+                    i++;
+                }
+                break;
+            case Quoting::SINGLE:
+                if (c == '\'') {
+                    quoting = Quoting::NONE;
+                }
+                break;
+            case Quoting::DOUBLE:
+                if (c == '"') {
+                    quoting = Quoting::NONE;
+                } else if (c == '\\') {
+                    i++;
+                }
+                break;
+        }
+    }
+    return quoting;
+}
+
+void CommandTemplate::appendQuery(std::string& out, TermSpan terms, Escaping escaping, Quoting quoting) {
+    bool own_quotes = escaping == Escaping::SHELL && quoting == Quoting::NONE;
+    if (own_quotes) {
+        out += '\'';
+    }
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (escaping == Escaping::URL) {
+            if (i > 0) out += '+';
+            appendUrlEncoded(out, terms[i]);
+        } else {
+            if (i > 0) out += ' ';
+            if (quoting == Quoting::DOUBLE) {
+                appendDoubleQuotedBody(out, terms[i]);
+            } else {
+                appendShellBody(out, terms[i]);
+            }
+        }
+    }
+    if (own_quotes) {
+        out += '\'';
+    }
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "term_span.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Action command with query placeholders, split into literal text and placeholders
+// once when the action is loaded, so activation is one linear fill:
+//   {query}             all terms joined with spaces
+//   {termN}             the N-th term, starting at 1; empty if there are fewer terms
+//   {query_urlencoded}  the query, always URL-encoded
+// Anything else in braces, like {item} or ${HOME}, is kept as written. Shell escaping
+// follows the quotes around the placeholder: {query} becomes one quoted word, inside
+// '...' only its escaped body, and inside "..." the body with " \ $ ` backslashed.
+class CommandTemplate {
+public:
+    // How {query} and {termN} are escaped; chosen by the action type
+    enum class Escaping : uint8_t {
+        SHELL, // Single-quoted shell word
+        URL    // Percent-encoded
+    };
+
+    CommandTemplate() = default;
+
+    // An empty template when command has no placeholders
+    static CommandTemplate compile(std::string_view command, Escaping escaping);
+
+    bool empty() const { return segments_.empty(); }
+    // Replaces out with the command for these terms
+    void fill(TermSpan terms, std::string& out) const;
+
+private:
+    enum class Kind : uint8_t {
+        LITERAL,
+        QUERY,
+        TERM,
+        QUERY_URLENCODED
+    };
+
+    // Shell quotes open where a placeholder stands
+    enum class Quoting : uint8_t {
+        NONE,
+        SINGLE,
+        DOUBLE
+    };
+
+    struct Segment {
+        Kind kind;
+        Quoting quoting; // Placeholders only
+        uint32_t begin;  // LITERAL: range in literals_; TERM: term index
+        uint32_t length;
+    };
+
+    std::string literals_;
+    std::vector<Segment> segments_;
+    Escaping escaping_ = Escaping::SHELL;
+
+    static Quoting advanceQuoting(std::string_view text, Quoting quoting);
+    static void appendQuery(std::string& out, TermSpan terms, Escaping escaping, Quoting quoting);
+};
+
+// Appends text as one single-quoted shell word
+void appendShellQuoted(std::string& out, std::string_view text);
+// Appends text percent-encoded, spaces as '+'
+void appendUrlEncoded(std::string& out, std::string_view text);
+
+} // namespace PrimeCuts
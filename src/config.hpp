@@ -1,8 +1,11 @@
 #pragma once
 
+#include "command_template.hpp"
+#include "param_map.hpp"
 #include <string>
 #include <vector>
 #include <map>
+#include <optional>
 
 namespace PrimeCuts {
 
@@ -21,7 +24,9 @@ struct Action {
     ActionType type;
     std::string command;
     std::vector<std::string> keywords;
-    std::map<std::string, std::string> extra_params;
+    ParamMap extra_params; // From "extra_params"; nested objects are flattened to "env.NAME"
+    CommandTemplate command_template; // Compiled from command when it has placeholders
+    bool expand_placeholders = true;  // False for generated actions, their command is run as it is
     
     Action() = default;
     Action(const std::string& id, const std::string& name, const std::string& description, 
@@ -31,11 +36,34 @@ struct Action {
           type(type), command(command), keywords(keywords) {}
 };
 
+enum class SourceType {
+    SSH_HOSTS,
+    SYSTEMD_UNITS,
+    DIRECTORIES,
+    SCRIPT,
+    DESKTOP_ENTRIES,
+    SHELL_HISTORY,
+    BOOKMARKS
+};
+
+// Generator that fills a group with actions at runtime instead of listing them in config.json
+struct ActionSource {
+    SourceType type = SourceType::SCRIPT;
+    std::string path;            // File or directory the generator reads; watched for changes
+    std::string generator;       // Command whose output lists the items (SCRIPT, SYSTEMD_UNITS)
+    std::string command;         // Command for each generated action, "{item}" is replaced
+    ActionType action_type = ActionType::TERMINAL_COMMAND;
+    unsigned int refresh_interval = 0; // Seconds between refreshes, 0 = only on startup and file change
+    unsigned int max_items = 0;  // SHELL_HISTORY: most recent distinct commands that are kept
+};
+
 struct Group {
     std::string name;
     std::string description;
     std::string icon;
+    std::string prefix; // Optional: a query starting with this word only searches this group
     std::vector<Action> actions;
+    std::optional<ActionSource> source;
     
     Group() = default;
     Group(const std::string& name, const std::string& description, const std::string& icon)
@@ -1,17 +1,76 @@
 #include "config_loader.hpp"
+#include "json_reader.hpp"
 #include "logger.hpp"
 #include "constants.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
+#include <map>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <dirent.h>
 
 namespace PrimeCuts {
 
+namespace {
+
+// Index of the quote that ends the string opened at quote_start, escaped quotes are skipped
+size_t findStringEnd(const std::string& content, size_t quote_start) {
+    for (size_t pos = quote_start + 1; pos < content.length(); ++pos) {
+        if (content[pos] == '\\') {
+            pos++;
+        } else if (content[pos] == '"') {
+            return pos;
+        }
+    }
+    return std::string::npos;
+}
+
+// Position of "key" as a member of the object content starts with, skipping the members
+// of nested objects and arrays; npos if the object itself has no such member
+size_t findMemberKey(const std::string& content, const std::string& key) {
+    int depth = 0;
+    for (size_t pos = 0; pos < content.length(); ++pos) {
+        char c = content[pos];
+        if (c == '"') {
+            size_t end = findStringEnd(content, pos);
+            if (end == std::string::npos) {
+                return std::string::npos;
+            }
+            if (depth == 1 && content.compare(pos + 1, end - pos - 1, key) == 0) {
+                size_t next = content.find_first_not_of(" \t\r\n", end + 1);
+                if (next != std::string::npos && content[next] == ':') {
+                    return pos;
+                }
+            }
+            pos = end;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                break;
+            }
+        }
+    }
+    return std::string::npos;
+}
+
+// The value of the string between the two quotes with its escapes resolved
+std::string decodeString(const std::string& content, size_t quote_start, size_t quote_end) {
+    std::string value;
+    if (!JsonReader::decodeString(std::string_view(content).substr(quote_start, quote_end - quote_start + 1), value)) {
+        LOG_WARNING("Invalid escape in config string: " + content.substr(quote_start, quote_end - quote_start + 1));
+        return content.substr(quote_start + 1, quote_end - quote_start - 1);
+    }
+    return value;
+}
+
+} // anonymous namespace
+
 std::string ConfigLoader::getDefaultConfigPath() {
     const char* home = getenv("HOME");
     if (home) {
@@ -82,20 +141,132 @@ void ConfigLoader::createDefaultConfig(Config& config) {
 bool ConfigLoader::loadConfig(const std::string& config_path, Config& config) {
     std::string path = config_path.empty() ? getDefaultConfigPath() : config_path;
     
-    std::ifstream file(path);
-    if (!file.is_open()) {
+    std::string content;
+    if (!readFile(path, content)) {
         LOG_WARNING("Config file not found at: " + path);
         LOG_INFO("Creating default configuration...");
         createDefaultConfig(config);
-        return saveConfig(path, config);
+        if (!saveConfig(path, config)) {
+            return false;
+        }
+    } else if (!loadFromJson(content, config)) {
+        return false;
     }
     
+    // Groups from conf.d/*.json follow the groups of config.json
+    FragmentChanges fragments = reloadFragments(getFragmentDirectory(path));
+    for (auto& group : fragments.updated_groups) {
+        config.groups.push_back(std::move(group));
+    }
+    return true;
+}
+
+std::string ConfigLoader::getFragmentDirectory(const std::string& config_path) {
+    std::string path = config_path.empty() ? getDefaultConfigPath() : config_path;
+    size_t last_slash = path.find_last_of('/');
+    return (last_slash == std::string::npos ? std::string() : path.substr(0, last_slash + 1)) + Constants::CONFIG_FRAGMENT_SUBDIR;
+}
+
+// Files contribute their groups in name order, e.g. 10-team.json before 20-personal.json
+std::vector<std::string> ConfigLoader::listFragments(const std::string& directory) {
+    std::vector<std::string> paths;
+    if (DIR* dir = opendir(directory.c_str())) {
+        const std::string suffix = ".json";
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name[0] != '.' && name.size() > suffix.size() &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                paths.push_back(directory + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+size_t ConfigLoader::hashConfigFiles(const std::string& config_path) {
+    std::string path = config_path.empty() ? getDefaultConfigPath() : config_path;
+    std::vector<std::string> paths = listFragments(getFragmentDirectory(path));
+    paths.insert(paths.begin(), path);
+    
+    size_t hash = 0;
+    std::string content;
+    for (const auto& file : paths) {
+        content.clear();
+        readFile(file, content); // A missing file hashes like an empty one
+        for (size_t part : {std::hash<std::string>{}(file), std::hash<std::string>{}(content)}) {
+            hash ^= part + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+    }
+    return hash;
+}
+
+FragmentChanges ConfigLoader::reloadFragments(const std::string& directory) {
+    FragmentChanges changes;
+    std::vector<std::string> paths = listFragments(directory);
+    
+    std::map<std::string, ConfigFragment> current;
+    for (const auto& path : paths) {
+        auto previous = fragments_.find(path);
+        std::string content;
+        if (!readFile(path, content)) {
+            // Vanished since readdir, or unreadable: treated like a removed file
+            continue;
+        }
+        
+        size_t content_hash = std::hash<std::string>{}(content);
+        if (previous != fragments_.end() && previous->second.content_hash == content_hash) {
+            current.insert(*previous);
+            continue;
+        }
+        
+        std::vector<Group> groups;
+        if (!parseGroups(content, groups)) {
+            // Probably saved halfway by an editor; keep what the file contributed before
+            LOG_WARNING("Ignoring config file without a valid 'groups' array: " + path);
+            if (previous != fragments_.end()) {
+                current.insert(*previous);
+            }
+            continue;
+        }
+        
+        ConfigFragment fragment;
+        fragment.content_hash = content_hash;
+        for (auto& group : groups) {
+            fragment.group_names.push_back(group.name);
+            changes.updated_groups.push_back(std::move(group));
+        }
+        if (previous != fragments_.end()) {
+            for (const auto& name : previous->second.group_names) {
+                if (std::find(fragment.group_names.begin(), fragment.group_names.end(), name) == fragment.group_names.end()) {
+                    changes.removed_groups.push_back(name);
+                }
+            }
+        }
+        changes.files_parsed++;
+        current.emplace(path, std::move(fragment));
+    }
+    
+    for (const auto& [path, fragment] : fragments_) {
+        if (current.find(path) == current.end()) {
+            changes.removed_groups.insert(changes.removed_groups.end(), fragment.group_names.begin(), fragment.group_names.end());
+        }
+    }
+    
+    fragments_.swap(current);
+    return changes;
+}
+
+bool ConfigLoader::readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
     std::stringstream buffer;
     buffer << file.rdbuf();
-    std::string content = buffer.str();
-    file.close();
-    
-    return loadFromJson(content, config);
+    content = buffer.str();
+    return true;
 }
 
 bool ConfigLoader::saveConfig(const std::string& config_path, const Config& config) {
@@ -108,15 +279,19 @@ bool ConfigLoader::saveConfig(const std::string& config_path, const Config& conf
         mkdir(dir.c_str(), 0755);
     }
     
-    std::ofstream file(path);
-    if (!file.is_open()) {
-        LOG_ERROR("Failed to create config file at: " + path);
+    // Written next to the original and renamed over it, so a reader never sees half a file
+    AtomicFile file(path);
+    if (!file.open()) {
+        LOG_ERROR("Failed to create config file: " + file.error());
         return false;
     }
     
-    std::string json_content = saveToJson(config);
-    file << json_content;
-    file.close();
+    JsonWriter json(file);
+    writeJson(json, config);
+    if (!file.commit()) {
+        LOG_ERROR("Failed to write config file: " + file.error());
+        return false;
+    }
     
     LOG_INFO("Configuration saved to: " + path);
     return true;
@@ -141,44 +316,12 @@ bool ConfigLoader::loadFromJson(const std::string& content, Config& config) {
             return true;
         }
         
-        size_t array_start = content.find("[", groups_start);
-        if (array_start == std::string::npos) {
+        if (!parseGroups(content, config.groups)) {
             LOG_WARNING("Invalid groups array format, using default configuration");
             createDefaultConfig(config);
             return true;
         }
         
-        // Find each group object
-        size_t current_pos = array_start + 1;
-        while (current_pos < content.length()) {
-            // Skip whitespace
-            while (current_pos < content.length() && (content[current_pos] == ' ' || content[current_pos] == '\n' || content[current_pos] == '\t')) {
-                current_pos++;
-            }
-            
-            if (current_pos >= content.length() || content[current_pos] == ']') {
-                break; // End of groups array
-            }
-            
-            if (content[current_pos] == '{') {
-                // Parse group object
-                Group group;
-                size_t group_end = findMatchingBrace(content, current_pos);
-                if (group_end != std::string::npos) {
-                    std::string group_content = content.substr(current_pos, group_end - current_pos + 1);
-                    if (parseGroup(group_content, group)) {
-                        config.groups.push_back(group);
-                    }
-                    current_pos = group_end + 1;
-                }
-            }
-            
-            // Skip to next group or end
-            while (current_pos < content.length() && content[current_pos] != '{' && content[current_pos] != ']') {
-                current_pos++;
-            }
-        }
-        
         // Parse global settings
         parseGlobalSettings(content, config);
         
@@ -193,67 +336,115 @@ bool ConfigLoader::loadFromJson(const std::string& content, Config& config) {
     }
 }
 
-std::string ConfigLoader::saveToJson(const Config& config) {
-    std::stringstream json;
-    json << "{\n";
-    json << "  \"groups\": [\n";
-    
-    for (size_t g = 0; g < config.groups.size(); ++g) {
-        const auto& group = config.groups[g];
-        json << "    {\n";
-        json << "      \"name\": \"" << group.name << "\",\n";
-        json << "      \"description\": \"" << group.description << "\",\n";
-        json << "      \"icon\": \"" << group.icon << "\",\n";
-        json << "      \"actions\": [\n";
+bool ConfigLoader::parseGroups(const std::string& content, std::vector<Group>& groups) {
+    size_t groups_start = content.find("\"groups\"");
+    size_t array_start = groups_start == std::string::npos ? groups_start : content.find("[", groups_start);
+    if (array_start == std::string::npos) {
+        return false;
+    }
+    
+    // Find each group object
+    size_t current_pos = array_start + 1;
+    while (current_pos < content.length()) {
+        // Skip whitespace
+        while (current_pos < content.length() && (content[current_pos] == ' ' || content[current_pos] == '\n' || content[current_pos] == '\t')) {
+            current_pos++;
+        }
+        
+        if (current_pos >= content.length() || content[current_pos] == ']') {
+            break; // End of groups array
+        }
         
-        for (size_t a = 0; a < group.actions.size(); ++a) {
-            const auto& action = group.actions[a];
-            json << "        {\n";
-            json << "          \"id\": \"" << action.id << "\",\n";
-            json << "          \"name\": \"" << action.name << "\",\n";
-            json << "          \"description\": \"" << action.description << "\",\n";
-            json << "          \"icon\": \"" << action.icon << "\",\n";
-            json << "          \"type\": \"";
-            switch (action.type) {
-                case ActionType::COMMAND: json << "command"; break;
-                case ActionType::TERMINAL_COMMAND: json << "terminal_command"; break;
-                case ActionType::URL: json << "url"; break;
-                case ActionType::APPLICATION: json << "application"; break;
+        if (content[current_pos] == '{') {
+            // Parse group object
+            Group group;
+            size_t group_end = findMatchingBrace(content, current_pos);
+            if (group_end != std::string::npos) {
+                std::string group_content = content.substr(current_pos, group_end - current_pos + 1);
+                if (parseGroup(group_content, group)) {
+                    groups.push_back(group);
+                }
+                current_pos = group_end + 1;
             }
-            json << "\",\n";
-            json << "          \"command\": \"" << action.command << "\",\n";
-            json << "          \"keywords\": [";
-            for (size_t k = 0; k < action.keywords.size(); ++k) {
-                json << "\"" << action.keywords[k] << "\"";
-                if (k < action.keywords.size() - 1) json << ", ";
+        }
+        
+        // Skip to next group or end
+        while (current_pos < content.length() && content[current_pos] != '{' && content[current_pos] != ']') {
+            current_pos++;
+        }
+    }
+    return true;
+}
+
+void ConfigLoader::writeJson(JsonWriter& json, const Config& config) {
+    json.beginObject();
+    json.key("groups");
+    json.beginArray();
+    
+    for (const auto& group : config.groups) {
+        json.beginObject();
+        json.member("name", group.name);
+        json.member("description", group.description);
+        json.member("icon", group.icon);
+        if (!group.prefix.empty()) {
+            json.member("prefix", group.prefix);
+        }
+        if (group.source) {
+            const auto& source = *group.source;
+            json.key("source");
+            json.beginObject();
+            json.member("type", sourceTypeToString(source.type));
+            json.member("path", source.path);
+            json.member("generator", source.generator);
+            json.member("command", source.command);
+            json.member("action_type", actionTypeToString(source.action_type));
+            if (source.max_items > 0) {
+                json.member("max_items", std::to_string(source.max_items));
             }
-            json << "]\n";
-            json << "        }";
-            if (a < group.actions.size() - 1) json << ",";
-            json << "\n";
+            json.member("interval", std::to_string(source.refresh_interval));
+            json.endObject();
         }
         
-        json << "      ]\n";
-        json << "    }";
-        if (g < config.groups.size() - 1) json << ",";
-        json << "\n";
+        json.key("actions");
+        json.beginArray();
+        for (const auto& action : group.actions) {
+            json.beginObject();
+            json.member("id", action.id);
+            json.member("name", action.name);
+            json.member("description", action.description);
+            json.member("icon", action.icon);
+            json.member("type", actionTypeToString(action.type));
+            json.member("command", action.command);
+            json.key("keywords");
+            json.beginArray(true);
+            for (const auto& keyword : action.keywords) {
+                json.string(keyword);
+            }
+            json.endArray();
+            if (!action.extra_params.empty()) {
+                json.key(Constants::EXTRA_PARAMS_KEY);
+                json.beginObject(true);
+                for (const auto& [key, value] : action.extra_params) {
+                    json.member(key, value);
+                }
+                json.endObject();
+            }
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
     }
+    json.endArray();
     
-    json << "  ],\n";
-    json << "  \"global_settings\": {\n";
-    
-    size_t setting_count = 0;
+    // std::map keeps the settings sorted, the output does not depend on insertion order
+    json.key("global_settings");
+    json.beginObject();
     for (const auto& [key, value] : config.global_settings) {
-        json << "    \"" << key << "\": \"" << value << "\"";
-        if (setting_count < config.global_settings.size() - 1) json << ",";
-        json << "\n";
-        setting_count++;
+        json.member(key, value);
     }
-    
-    json << "  }\n";
-    json << "}\n";
-    
-    return json.str();
+    json.endObject();
+    json.endObject();
+    json.finish();
 }
 
 // JSON parsing helper functions
@@ -266,7 +457,13 @@ size_t ConfigLoader::findMatchingBrace(const std::string& content, size_t start_
     size_t pos = start_pos + 1;
     
     while (pos < content.length() && brace_count > 0) {
-        if (content[pos] == '{') {
+        if (content[pos] == '"') {
+            // Braces in strings, like awk '{print $1}' in a command, do not count
+            pos = findStringEnd(content, pos);
+            if (pos == std::string::npos) {
+                return std::string::npos;
+            }
+        } else if (content[pos] == '{') {
             brace_count++;
         } else if (content[pos] == '}') {
             brace_count--;
@@ -294,12 +491,12 @@ std::string ConfigLoader::extractStringValue(const std::string& content, const s
         return "";
     }
     
-    size_t quote_end = content.find("\"", quote_start + 1);
+    size_t quote_end = findStringEnd(content, quote_start);
     if (quote_end == std::string::npos) {
         return "";
     }
     
-    return content.substr(quote_start + 1, quote_end - quote_start - 1);
+    return decodeString(content, quote_start, quote_end);
 }
 
 std::vector<std::string> ConfigLoader::extractStringArray(const std::string& content, const std::string& key) {
@@ -320,27 +517,20 @@ std::vector<std::string> ConfigLoader::extractStringArray(const std::string& con
         return result;
     }
     
-    size_t array_end = content.find("]", array_start);
-    if (array_end == std::string::npos) {
-        return result;
-    }
-    
-    std::string array_content = content.substr(array_start + 1, array_end - array_start - 1);
-    
-    // Parse array elements
-    size_t pos = 0;
-    while (pos < array_content.length()) {
-        size_t quote_start = array_content.find("\"", pos);
-        if (quote_start == std::string::npos) {
+    // Parse array elements up to the closing bracket, which may also appear inside an element
+    size_t pos = array_start + 1;
+    while (pos < content.length()) {
+        size_t next = content.find_first_of("\"]", pos);
+        if (next == std::string::npos || content[next] == ']') {
             break;
         }
         
-        size_t quote_end = array_content.find("\"", quote_start + 1);
+        size_t quote_end = findStringEnd(content, next);
         if (quote_end == std::string::npos) {
             break;
         }
         
-        result.push_back(array_content.substr(quote_start + 1, quote_end - quote_start - 1));
+        result.push_back(decodeString(content, next, quote_end));
         pos = quote_end + 1;
     }
     
@@ -355,7 +545,166 @@ ActionType ConfigLoader::stringToActionType(const std::string& type_str) {
     return ActionType::COMMAND; // default
 }
 
+std::string ConfigLoader::actionTypeToString(ActionType type) {
+    switch (type) {
+        case ActionType::COMMAND: return "command";
+        case ActionType::TERMINAL_COMMAND: return "terminal_command";
+        case ActionType::URL: return "url";
+        case ActionType::APPLICATION: return "application";
+    }
+    return "command";
+}
+
+bool ConfigLoader::stringToSourceType(const std::string& type_str, SourceType& type) {
+    if (type_str == "ssh_hosts") { type = SourceType::SSH_HOSTS; return true; }
+    if (type_str == "systemd_units") { type = SourceType::SYSTEMD_UNITS; return true; }
+    if (type_str == "directories") { type = SourceType::DIRECTORIES; return true; }
+    if (type_str == "script") { type = SourceType::SCRIPT; return true; }
+    if (type_str == "desktop_entries") { type = SourceType::DESKTOP_ENTRIES; return true; }
+    if (type_str == "shell_history") { type = SourceType::SHELL_HISTORY; return true; }
+    if (type_str == "bookmarks") { type = SourceType::BOOKMARKS; return true; }
+    return false;
+}
+
+std::string ConfigLoader::sourceTypeToString(SourceType type) {
+    switch (type) {
+        case SourceType::SSH_HOSTS: return "ssh_hosts";
+        case SourceType::SYSTEMD_UNITS: return "systemd_units";
+        case SourceType::DIRECTORIES: return "directories";
+        case SourceType::SCRIPT: return "script";
+        case SourceType::DESKTOP_ENTRIES: return "desktop_entries";
+        case SourceType::SHELL_HISTORY: return "shell_history";
+        case SourceType::BOOKMARKS: return "bookmarks";
+    }
+    return "script";
+}
+
+bool ConfigLoader::parseSource(const std::string& source_content, ActionSource& source) {
+    std::string type_str = extractStringValue(source_content, "type");
+    if (!stringToSourceType(type_str, source.type)) {
+        LOG_WARNING("Unknown action source type: '" + type_str + "'");
+        return false;
+    }
+    
+    source.path = extractStringValue(source_content, "path");
+    source.generator = extractStringValue(source_content, "generator");
+    source.command = extractStringValue(source_content, "command");
+    
+    std::string action_type_str = extractStringValue(source_content, "action_type");
+    if (!action_type_str.empty()) {
+        source.action_type = stringToActionType(action_type_str);
+    }
+    
+    std::string interval_str = extractStringValue(source_content, "interval");
+    source.refresh_interval = static_cast<unsigned int>(strtoul(interval_str.c_str(), nullptr, 10));
+    
+    std::string max_items_str = extractStringValue(source_content, "max_items");
+    source.max_items = static_cast<unsigned int>(strtoul(max_items_str.c_str(), nullptr, 10));
+    
+    // Fill in per-type defaults so the generators never see empty fields
+    switch (source.type) {
+        case SourceType::SSH_HOSTS:
+            if (source.path.empty()) source.path = Constants::DEFAULT_SSH_CONFIG_PATH;
+            if (source.command.empty()) source.command = Constants::DEFAULT_SSH_COMMAND;
+            break;
+        case SourceType::SYSTEMD_UNITS:
+            if (source.generator.empty()) source.generator = Constants::DEFAULT_SYSTEMD_GENERATOR;
+            if (source.command.empty()) source.command = Constants::DEFAULT_SYSTEMD_COMMAND;
+            break;
+        case SourceType::DIRECTORIES:
+            if (source.command.empty()) source.command = Constants::DEFAULT_DIRECTORY_COMMAND;
+            if (action_type_str.empty()) source.action_type = ActionType::COMMAND;
+            if (source.path.empty()) {
+                LOG_WARNING("Directory source requires a 'path'");
+                return false;
+            }
+            break;
+        case SourceType::SCRIPT:
+            if (source.generator.empty()) {
+                LOG_WARNING("Script source requires a 'generator' command");
+                return false;
+            }
+            break;
+        case SourceType::DESKTOP_ENTRIES:
+            if (source.command.empty()) source.command = Constants::DEFAULT_DESKTOP_ENTRY_COMMAND;
+            if (action_type_str.empty()) source.action_type = ActionType::APPLICATION;
+            break;
+        case SourceType::SHELL_HISTORY:
+            if (source.path.empty()) {
+                const char* shell = getenv("SHELL");
+                bool zsh = shell && std::string(shell).find("zsh") != std::string::npos;
+                source.path = zsh ? Constants::DEFAULT_ZSH_HISTORY_PATH : Constants::DEFAULT_BASH_HISTORY_PATH;
+            }
+            if (source.command.empty()) source.command = Constants::SOURCE_ITEM_PLACEHOLDER;
+            if (source.max_items == 0) source.max_items = Constants::DEFAULT_HISTORY_MAX_ITEMS;
+            break;
+        case SourceType::BOOKMARKS:
+            if (source.path.empty()) source.path = Constants::DEFAULT_BOOKMARKS_PATH;
+            if (source.command.empty()) source.command = Constants::SOURCE_ITEM_PLACEHOLDER;
+            if (action_type_str.empty()) source.action_type = ActionType::URL;
+            break;
+    }
+    
+    return true;
+}
+
+void ConfigLoader::parseParams(const std::string& object_content, const std::string& prefix, ParamMap& params) {
+    // "key": "value" pairs; a nested object's keys get "key." in front
+    size_t pos = 1;
+    while (pos < object_content.size()) {
+        size_t key_start = object_content.find('"', pos);
+        if (key_start == std::string::npos) {
+            break;
+        }
+        size_t key_end = findStringEnd(object_content, key_start);
+        size_t colon_pos = key_end == std::string::npos ? key_end : object_content.find(':', key_end);
+        if (colon_pos == std::string::npos) {
+            break;
+        }
+        std::string key = prefix + decodeString(object_content, key_start, key_end);
+        
+        size_t value_start = object_content.find_first_not_of(" \t\r\n", colon_pos + 1);
+        if (value_start == std::string::npos) {
+            break;
+        }
+        if (object_content[value_start] == '{') {
+            size_t value_end = findMatchingBrace(object_content, value_start);
+            if (value_end == std::string::npos) {
+                break;
+            }
+            parseParams(object_content.substr(value_start, value_end - value_start + 1), key + ".", params);
+            pos = value_end + 1;
+        } else if (object_content[value_start] == '"') {
+            size_t value_end = findStringEnd(object_content, value_start);
+            if (value_end == std::string::npos) {
+                break;
+            }
+            params.set(key, decodeString(object_content, value_start, value_end));
+            pos = value_end + 1;
+        } else {
+            // Numbers and booleans are kept as written
+            size_t value_end = object_content.find_first_of(",}\r\n", value_start);
+            size_t last = object_content.find_last_not_of(" \t", value_end == std::string::npos ? value_end : value_end - 1);
+            params.set(key, std::string_view(object_content).substr(value_start, last - value_start + 1));
+            pos = value_end;
+        }
+    }
+}
+
 bool ConfigLoader::parseAction(const std::string& action_content, Action& action) {
+    // Parameter names may shadow action fields, so they are cut out before the fields are read
+    size_t params_start = action_content.find(std::string("\"") + Constants::EXTRA_PARAMS_KEY + "\"");
+    if (params_start != std::string::npos) {
+        size_t object_start = action_content.find('{', params_start);
+        size_t object_end = findMatchingBrace(action_content, object_start);
+        if (object_end != std::string::npos) {
+            parseParams(action_content.substr(object_start, object_end - object_start + 1), "", action.extra_params);
+            std::string fields = action_content;
+            fields.erase(params_start, object_end - params_start + 1);
+            return parseAction(fields, action);
+        }
+    }
+    
     action.id = extractStringValue(action_content, "id");
     action.name = extractStringValue(action_content, "name");
     action.description = extractStringValue(action_content, "description");
@@ -370,12 +719,35 @@ bool ConfigLoader::parseAction(const std::string& action_content, Action& action
 }
 
 bool ConfigLoader::parseGroup(const std::string& group_content, Group& group) {
-    group.name = extractStringValue(group_content, "name");
-    group.description = extractStringValue(group_content, "description");
-    group.icon = extractStringValue(group_content, "icon");
+    // Only the group's own members count, an action or source may have keys of the same name
+    auto member_string = [&](const std::string& key) {
+        size_t key_pos = findMemberKey(group_content, key);
+        return key_pos != std::string::npos ? extractStringValue(group_content.substr(key_pos), key) : std::string();
+    };
+    group.name = member_string("name");
+    group.description = member_string("description");
+    group.icon = member_string("icon");
+    
+    // Optional activation prefix
+    group.prefix = member_string("prefix");
+    
+    // Optional dynamic action source
+    size_t source_start = findMemberKey(group_content, "source");
+    if (source_start != std::string::npos) {
+        size_t object_start = group_content.find("{", source_start);
+        size_t object_end = findMatchingBrace(group_content, object_start);
+        if (object_end != std::string::npos) {
+            ActionSource source;
+            if (parseSource(group_content.substr(object_start, object_end - object_start + 1), source)) {
+                group.source = source;
+            } else {
+                LOG_WARNING("Ignoring invalid action source in group: " + group.name);
+            }
+        }
+    }
     
     // Find actions array
-    size_t actions_start = group_content.find("\"actions\"");
+    size_t actions_start = findMemberKey(group_content, "actions");
     if (actions_start == std::string::npos) {
         return !group.name.empty();
     }
@@ -465,6 +837,16 @@ void ConfigLoader::parseGlobalSettings(const std::string& content, Config& confi
     } else {
         config.global_settings[Constants::SETTING_ENABLE_NOTIFICATIONS] = "true";
     }
+    
+    // Optional tuning settings are only stored when present
+    for (const char* key : {Constants::SETTING_SEARCH_SHARDS, Constants::SETTING_MAX_RESULTS, Constants::SETTING_MATCH_MODE,
+                            Constants::SETTING_SEARCH_BUDGET_MS, Constants::SETTING_COALESCE_WINDOW_MS,
+                            Constants::SETTING_IDLE_TIMEOUT_MINUTES, Constants::SETTING_REMEMBER_QUERIES}) {
+        std::string value = extractStringValue(settings_content, key);
+        if (!value.empty()) {
+            config.global_settings[key] = value;
+        }
+    }
 }
 
 } // namespace PrimeCuts
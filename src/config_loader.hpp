@@ -1,11 +1,23 @@
 #pragma once
 
 #include "config.hpp"
+#include "json_writer.hpp"
+#include <map>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace PrimeCuts {
 
+// Groups that changed when the conf.d directory was scanned again
+struct FragmentChanges {
+    std::vector<Group> updated_groups;        // New groups, or new versions of existing ones
+    std::vector<std::string> removed_groups;  // Names of groups no file provides anymore
+    size_t files_parsed = 0;
+
+    bool empty() const { return updated_groups.empty() && removed_groups.empty(); }
+};
+
 class ConfigLoader {
 public:
     ConfigLoader() = default;
@@ -15,19 +27,41 @@ public:
     bool saveConfig(const std::string& config_path, const Config& config);
     void createDefaultConfig(Config& config);
     
+    // conf.d next to the config file: every *.json there contributes groups
+    std::string getFragmentDirectory(const std::string& config_path);
+    // Reparses only the files whose content changed since the previous call
+    FragmentChanges reloadFragments(const std::string& directory);
+    // Combined hash of the paths and contents of config.json and the conf.d files, without parsing them
+    size_t hashConfigFiles(const std::string& config_path);
+    
 private:
+    struct ConfigFragment {
+        size_t content_hash = 0;
+        std::vector<std::string> group_names;
+    };
+    
+    std::map<std::string, ConfigFragment> fragments_; // By file path
+    
+    bool readFile(const std::string& path, std::string& content);
+    std::vector<std::string> listFragments(const std::string& directory);
+    bool parseGroups(const std::string& content, std::vector<Group>& groups);
     bool loadFromJson(const std::string& content, Config& config);
-    std::string saveToJson(const Config& config);
+    void writeJson(JsonWriter& json, const Config& config);
     std::string getDefaultConfigPath();
     
     // JSON parsing helpers
     size_t findMatchingBrace(const std::string& content, size_t start_pos);
     bool parseGroup(const std::string& group_content, Group& group);
     bool parseAction(const std::string& action_content, Action& action);
+    bool parseSource(const std::string& source_content, ActionSource& source);
+    void parseParams(const std::string& object_content, const std::string& prefix, ParamMap& params);
     void parseGlobalSettings(const std::string& content, Config& config);
     std::string extractStringValue(const std::string& content, const std::string& key);
     std::vector<std::string> extractStringArray(const std::string& content, const std::string& key);
     ActionType stringToActionType(const std::string& type_str);
+    std::string actionTypeToString(ActionType type);
+    bool stringToSourceType(const std::string& type_str, SourceType& type);
+    std::string sourceTypeToString(SourceType type);
 };
 
 } // namespace PrimeCuts
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace PrimeCuts {
@@ -9,6 +10,7 @@ namespace Constants {
     const char* const DBUS_SERVICE_NAME = "de.primeapi.PrimeCuts";
     const char* const DBUS_OBJECT_PATH = "/de/primeapi/PrimeCuts";
     const char* const DBUS_INTERFACE_NAME = "org.gnome.Shell.SearchProvider2";
+    const char* const DBUS_ERROR_FAILED = "org.freedesktop.DBus.Error.Failed";
     
     // Method names
     const char* const METHOD_GET_INITIAL_RESULT_SET = "GetInitialResultSet";
@@ -23,18 +25,69 @@ namespace Constants {
     // Configuration
     const char* const DEFAULT_CONFIG_SUBDIR = "/.config/primecuts/";
     const char* const DEFAULT_CONFIG_FILENAME = "config.json";
+    const char* const CONFIG_FRAGMENT_SUBDIR = "conf.d";
+    const char* const SOURCE_CACHE_SUBDIR = "primecuts/sources";
+    
+    // Warm-start snapshot
+    const char* const SNAPSHOT_FILENAME = "primecuts/warm-snapshot.bin"; // In the user cache directory
+    const size_t SNAPSHOT_HOT_QUERIES = 256;       // Most frequent queries whose results are kept
+    const size_t SNAPSHOT_TRACKED_QUERIES = 4096;  // Distinct queries counted before the counts decay
+    const unsigned int SNAPSHOT_INTERVAL_SECONDS = 600;
+    
+    // Dynamic action sources
+    const char* const SOURCE_ITEM_PLACEHOLDER = "{item}";
+    const char* const SOURCE_ID_PREFIX = "src:";
+    const char* const DEFAULT_SSH_CONFIG_PATH = "~/.ssh/config";
+    const char* const DEFAULT_SSH_COMMAND = "ssh {item}";
+    const char* const DEFAULT_SYSTEMD_GENERATOR = "systemctl list-unit-files --type=service --no-legend --no-pager";
+    const char* const DEFAULT_SYSTEMD_COMMAND = "systemctl status {item}";
+    const char* const DEFAULT_DIRECTORY_COMMAND = "xdg-open {item}";
+    const char* const DEFAULT_DESKTOP_ENTRY_COMMAND = "{item} &"; // Do not wait for the application to exit
+    const char* const DEFAULT_BASH_HISTORY_PATH = "~/.bash_history";
+    const char* const DEFAULT_ZSH_HISTORY_PATH = "~/.zsh_history";
+    const unsigned int DEFAULT_HISTORY_MAX_ITEMS = 5000;
+    const char* const DEFAULT_BOOKMARKS_PATH = "~/.config/chromium/Default/Bookmarks";
     
     // Global settings keys
     const char* const SETTING_TERMINAL_COMMAND = "terminal_command";
     const char* const SETTING_BROWSER_COMMAND = "browser_command";
     const char* const SETTING_ENABLE_NOTIFICATIONS = "enable_notifications";
+    const char* const SETTING_SEARCH_SHARDS = "search_shards";
+    const char* const SETTING_MAX_RESULTS = "max_results";
+    const char* const SETTING_MATCH_MODE = "match_mode";
+    const char* const SETTING_SEARCH_BUDGET_MS = "search_budget_ms";
+    const char* const SETTING_COALESCE_WINDOW_MS = "coalesce_window_ms";
+    const char* const SETTING_IDLE_TIMEOUT_MINUTES = "idle_timeout_minutes";
+    const char* const SETTING_REMEMBER_QUERIES = "remember_queries";
+    
+    // Per-action extra_params keys
+    const char* const EXTRA_PARAMS_KEY = "extra_params";
+    const char* const PARAM_CWD = "cwd";
+    const char* const PARAM_ENV_PREFIX = "env.";
+    const char* const PARAM_TIMEOUT = "timeout";
+    const char* const PARAM_TERMINAL_PROFILE = "terminal_profile";
+    const char* const PARAM_CLIPBOARD_TEXT = "clipboard_text";
     
     // Command line arguments
     const char* const ARG_DEBUG = "--debug";
+    const char* const ARG_BENCHMARK_SHARDS = "--benchmark-shards";
+    const size_t DEFAULT_BENCHMARK_ACTIONS = 100000;
+    const char* const ARG_QUERY = "--query";
+    const char* const ARG_BATCH = "--batch";
+    const char* const ARG_ITERATIONS = "--iterations";
+    const char* const ARG_METAS = "--metas";
+    const char* const ARG_CONFIG = "--config";
+    const char* const ARG_ALLOC_BUDGET = "--alloc-budget";
+    const char* const ARG_RECORD_TRACE = "--record-trace";
+    const char* const ARG_ANONYMIZE_TRACE = "--anonymize-trace";
+    const char* const ARG_REPLAY = "--replay";
+    const char* const ARG_REPLAY_SPEED = "--replay-speed";
+    const char* const REPLAY_SPEED_ORIGINAL = "original";
     
     // Virtual search actions
     const char* const SEARCH_GOOGLE_ID = "_search_google";
     const char* const SEARCH_CHATGPT_ID = "_search_chatgpt";
+    const char SESSION_ID_SEPARATOR = '#'; // Virtual ids carry their query session: "_search_google#42"
     const char* const GOOGLE_SEARCH_URL = "https://www.google.com/search?q=";
     const char* const CHATGPT_SEARCH_URL = "https://chatgpt.com/?q=";
 }
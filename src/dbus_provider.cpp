@@ -1,6 +1,8 @@
 #include "dbus_provider.hpp"
 #include "logger.hpp"
 #include "constants.hpp"
+#include "request_arena.hpp"
+#include "result_metas.hpp"
 #include <iostream>
 #include <sstream>
 
@@ -35,7 +37,12 @@ DBusSearchProvider::DBusSearchProvider(std::unique_ptr<CommandManager> command_m
     , main_loop_(nullptr)
     , introspection_data_(nullptr)
     , owner_id_(0)
-    , registration_id_(0) {
+    , registration_id_(0)
+    , trace_recorder_(nullptr) {
+    // Like main.cpp, serialize the icons of the config once instead of on the first metas request
+    if (command_manager_) {
+        icon_cache_.prepare(command_manager_->config());
+    }
 }
 
 DBusSearchProvider::~DBusSearchProvider() {
@@ -104,6 +111,13 @@ void DBusSearchProvider::handleMethodCall(
     auto* provider = static_cast<DBusSearchProvider*>(user_data);
     LOG_DEBUG("DBus method called: " + std::string(method_name) + " from " + std::string(sender));
     
+    if (provider->trace_recorder_) {
+        provider->trace_recorder_->record(method_name, parameters);
+    }
+    
+    // Everything the handler took from the arena is dead once it has replied
+    RequestArena::Scope request;
+    
     if (g_strcmp0(method_name, Constants::METHOD_GET_INITIAL_RESULT_SET) == 0) {
         provider->handleGetInitialResultSet(parameters, invocation);
     } else if (g_strcmp0(method_name, Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0) {
@@ -126,16 +140,17 @@ void DBusSearchProvider::handleGetInitialResultSet(GVariant* parameters, GDBusMe
     g_variant_iter_init(&iter, parameters);
     GVariant* terms_array = g_variant_iter_next_value(&iter);
     
-    std::vector<std::string> search_terms = extractSearchTerms(terms_array);
-    
-    if (terms_array) {
-        g_variant_unref(terms_array);
-    }
+    std::pmr::memory_resource* memory = RequestArena::forThread().resource();
+    std::pmr::vector<std::string_view> search_terms = extractSearchTerms(terms_array, memory);
     
     LOG_DEBUG("Total search terms extracted: " + std::to_string(search_terms.size()));
     
     // Use command manager to search for matching actions
-    std::vector<std::string> matches = command_manager_->searchActions(search_terms);
+    ResultIds matches = command_manager_->searchActions(TermSpan(search_terms.data(), search_terms.size()), memory);
+    
+    if (terms_array) {
+        g_variant_unref(terms_array);
+    }
     
     LOG_DEBUG("Search completed. Found " + std::to_string(matches.size()) + " matching actions");
     
@@ -143,7 +158,7 @@ void DBusSearchProvider::handleGetInitialResultSet(GVariant* parameters, GDBusMe
     g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
     for (const auto& id : matches) {
         g_variant_builder_add(&builder, "s", id.c_str());
-        LOG_DEBUG("Found match: " + id);
+        LOG_DEBUG("Found match: " + std::string(id));
     }
     
     LOG_DEBUG("Returning " + std::to_string(matches.size()) + " results");
@@ -167,16 +182,17 @@ void DBusSearchProvider::handleGetSubsearchResultSet(GVariant* parameters, GDBus
     // Get the terms array (second parameter)
     GVariant* terms_array = g_variant_iter_next_value(&outer_iter);
     
-    std::vector<std::string> search_terms = extractSearchTerms(terms_array);
-    
-    if (terms_array) {
-        g_variant_unref(terms_array);
-    }
+    std::pmr::memory_resource* memory = RequestArena::forThread().resource();
+    std::pmr::vector<std::string_view> search_terms = extractSearchTerms(terms_array, memory);
     
     LOG_DEBUG("Total subsearch terms extracted: " + std::to_string(search_terms.size()));
     
     // Use command manager to search for matching actions
-    std::vector<std::string> matches = command_manager_->searchActions(search_terms);
+    ResultIds matches = command_manager_->searchActions(TermSpan(search_terms.data(), search_terms.size()), memory);
+    
+    if (terms_array) {
+        g_variant_unref(terms_array);
+    }
     
     LOG_DEBUG("Subsearch completed. Found " + std::to_string(matches.size()) + " matching actions");
     
@@ -184,7 +200,7 @@ void DBusSearchProvider::handleGetSubsearchResultSet(GVariant* parameters, GDBus
     g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
     for (const auto& id : matches) {
         g_variant_builder_add(&builder, "s", id.c_str());
-        LOG_DEBUG("Found subsearch match: " + id);
+        LOG_DEBUG("Found subsearch match: " + std::string(id));
     }
     
     LOG_DEBUG("Returning " + std::to_string(matches.size()) + " subsearch results");
@@ -193,40 +209,10 @@ void DBusSearchProvider::handleGetSubsearchResultSet(GVariant* parameters, GDBus
 
 void DBusSearchProvider::handleGetResultMetas(GVariant* parameters, GDBusMethodInvocation* invocation) {
     LOG_DEBUG("Processing GetResultMetas request...");
-    GVariantIter iter;
-    gchar* id;
-    
-    g_variant_iter_init(&iter, parameters);
-    GVariant* ids_array = g_variant_iter_next_value(&iter);
-    
-    GVariantBuilder outer;
-    g_variant_builder_init(&outer, G_VARIANT_TYPE("aa{sv}"));
-    
-    if (ids_array) {
-        GVariantIter ids_iter;
-        g_variant_iter_init(&ids_iter, ids_array);
-        
-        while (g_variant_iter_next(&ids_iter, "s", &id)) {
-            LOG_DEBUG("Getting meta for ID: " + std::string(id));
-            const Action* action = command_manager_->getAction(id);
-            if (action) {
-                GVariantBuilder meta;
-                g_variant_builder_init(&meta, G_VARIANT_TYPE("a{sv}"));
-                g_variant_builder_add(&meta, "{sv}", "id", g_variant_new_string(id));
-                g_variant_builder_add(&meta, "{sv}", "name", g_variant_new_string(action->name.c_str()));
-                g_variant_builder_add(&meta, "{sv}", "description", g_variant_new_string(action->description.c_str()));
-                g_variant_builder_add(&meta, "{sv}", "icon", g_variant_new_string(action->icon.c_str()));
-                
-                g_variant_builder_add(&outer, "a{sv}", &meta);
-            } else {
-                LOG_DEBUG("No action found for ID: " + std::string(id));
-            }
-            g_free(id);
-        }
-        g_variant_unref(ids_array);
-    }
-    
-    g_dbus_method_invocation_return_value(invocation, g_variant_new("(aa{sv})", &outer));
+    MetaSources sources;
+    sources.manager = command_manager_.get();
+    sources.icons = &icon_cache_;
+    g_dbus_method_invocation_return_value(invocation, buildResultMetas(parameters, sources));
 }
 
 void DBusSearchProvider::handleActivateResult(GVariant* parameters, GDBusMethodInvocation* invocation) {
@@ -238,46 +224,42 @@ void DBusSearchProvider::handleActivateResult(GVariant* parameters, GDBusMethodI
     
     LOG_DEBUG("Activating result with ID: " + std::string(id));
     
-    // Extract terms for potential use in command execution
-    std::vector<std::string> terms;
-    if (terms_variant) {
-        GVariantIter terms_iter;
-        g_variant_iter_init(&terms_iter, terms_variant);
-        gchar* term;
-        while (g_variant_iter_next(&terms_iter, "s", &term)) {
-            terms.push_back(std::string(term));
-            g_free(term);
-        }
-        g_variant_unref(terms_variant);
-    }
+    // Borrow terms for potential use in command execution
+    std::vector<std::string_view> terms;
+    gsize term_count = 0;
+    const gchar** term_strings = g_variant_get_strv(terms_variant, &term_count);
+    terms.assign(term_strings, term_strings + term_count);
+    g_free(term_strings);
     
     // Use command manager to execute the action
     bool success = command_manager_->executeAction(id, terms);
     if (!success) {
         LOG_WARNING("Failed to execute action with ID: " + std::string(id));
     }
+    g_variant_unref(terms_variant);
     
     g_dbus_method_invocation_return_value(invocation, nullptr);
 }
 
-std::vector<std::string> DBusSearchProvider::extractSearchTerms(GVariant* terms_array) {
-    std::vector<std::string> search_terms;
+// The views point into terms_array, which must stay alive while they are used
+std::pmr::vector<std::string_view> DBusSearchProvider::extractSearchTerms(GVariant* terms_array,
+                                                                          std::pmr::memory_resource* memory) {
+    std::pmr::vector<std::string_view> search_terms(memory);
     
     LOG_DEBUG("Terms array is " + std::string(terms_array ? "not null" : "null"));
     
     if (terms_array) {
         LOG_DEBUG("Terms array type: " + std::string(g_variant_get_type_string(terms_array)));
-        LOG_DEBUG("Terms array size: " + std::to_string(g_variant_n_children(terms_array)));
         
-        GVariantIter terms_iter;
-        g_variant_iter_init(&terms_iter, terms_array);
+        gsize term_count = 0;
+        const gchar** terms = g_variant_get_strv(terms_array, &term_count);
+        search_terms.assign(terms, terms + term_count);
+        g_free(terms);
         
-        gchar* term;
-        while (g_variant_iter_next(&terms_iter, "s", &term)) {
-            std::string termStr(term);
-            LOG_DEBUG("Search term: '" + termStr + "' (length: " + std::to_string(termStr.length()) + ")");
-            search_terms.push_back(termStr);
-            g_free(term);
+        if (Logger::getInstance().isDebugEnabled()) {
+            for (const auto& term : search_terms) {
+                LOG_DEBUG("Search term: '" + std::string(term) + "' (length: " + std::to_string(term.size()) + ")");
+            }
         }
     }
     
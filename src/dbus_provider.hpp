@@ -2,8 +2,13 @@
 
 #include "config.hpp"
 #include "command_manager.hpp"
+#include "icon_cache.hpp"
+#include "trace.hpp"
 #include <gio/gio.h>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
 
 namespace PrimeCuts {
 
@@ -19,6 +24,9 @@ public:
     bool startService();
     void stopService();
     
+    // Every incoming call is also written to the recorder; not owned
+    void setTraceRecorder(TraceRecorder* recorder) { trace_recorder_ = recorder; }
+    
     static void handleMethodCall(
         GDBusConnection* connection,
         const gchar* sender,
@@ -31,17 +39,19 @@ public:
 
 private:
     std::unique_ptr<CommandManager> command_manager_;
+    IconCache icon_cache_;
     GMainLoop* main_loop_;
     GDBusNodeInfo* introspection_data_;
     guint owner_id_;
     guint registration_id_;
+    TraceRecorder* trace_recorder_;
     
     void handleGetInitialResultSet(GVariant* parameters, GDBusMethodInvocation* invocation);
     void handleGetSubsearchResultSet(GVariant* parameters, GDBusMethodInvocation* invocation);
     void handleGetResultMetas(GVariant* parameters, GDBusMethodInvocation* invocation);
     void handleActivateResult(GVariant* parameters, GDBusMethodInvocation* invocation);
     
-    std::vector<std::string> extractSearchTerms(GVariant* terms_array);
+    std::pmr::vector<std::string_view> extractSearchTerms(GVariant* terms_array, std::pmr::memory_resource* memory);
     
     static void onBusAcquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
     static void onNameAcquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
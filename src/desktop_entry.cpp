@@ -0,0 +1,245 @@
+#include "desktop_entry.hpp"
+#include <algorithm>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PrimeCuts {
+
+namespace {
+
+const std::string_view DESKTOP_ENTRY_GROUP = "[Desktop Entry]";
+const std::string_view FIELD_CODES = "fFuUdDnNickvm";
+
+std::string_view trimView(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Undoes the \s \n \t \r \\ escapes of string values; list separators "\;" stay escaped
+std::string unescapeValue(std::string_view value, bool keep_semicolons) {
+    std::string result;
+    result.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] != '\\' || i + 1 == value.size()) {
+            result += value[i];
+            continue;
+        }
+        switch (value[++i]) {
+            case 's': result += ' '; break;
+            case 'n': result += '\n'; break;
+            case 't': result += '\t'; break;
+            case 'r': result += '\r'; break;
+            case '\\': result += '\\'; break;
+            case ';':
+                if (keep_semicolons) result += '\\';
+                result += ';';
+                break;
+            default:
+                result += '\\';
+                result += value[i];
+                break;
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> splitList(std::string_view value) {
+    std::vector<std::string> items;
+    std::string item;
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' && i + 1 < value.size() && value[i + 1] == ';') {
+            item += ';';
+            ++i;
+        } else if (value[i] == ';') {
+            if (!item.empty()) items.push_back(std::move(item));
+            item.clear();
+        } else {
+            item += value[i];
+        }
+    }
+    if (!item.empty()) {
+        items.push_back(std::move(item));
+    }
+    return items;
+}
+
+// Exec with %f, %U and the other field codes removed and "%%" turned into "%"
+std::string stripFieldCodes(std::string_view exec) {
+    std::string result;
+    result.reserve(exec.size());
+    for (size_t i = 0; i < exec.size(); ++i) {
+        if (exec[i] != '%' || i + 1 == exec.size()) {
+            result += exec[i];
+        } else if (exec[i + 1] == '%') {
+            result += '%';
+            ++i;
+        } else if (FIELD_CODES.find(exec[i + 1]) != std::string_view::npos) {
+            ++i;
+        } else {
+            result += exec[i];
+        }
+    }
+    return std::string(trimView(result));
+}
+
+bool anyListed(const std::vector<std::string>& list, const std::vector<std::string>& desktops) {
+    return std::any_of(list.begin(), list.end(), [&](const std::string& item) {
+        return std::find(desktops.begin(), desktops.end(), item) != desktops.end();
+    });
+}
+
+// A localized value replaces the current one only if its language is preferred
+class LocalizedValue {
+public:
+    explicit LocalizedValue(size_t unlocalized_rank) : rank_(unlocalized_rank + 1) {}
+
+    bool offer(size_t rank) {
+        if (rank >= rank_) {
+            return false;
+        }
+        rank_ = rank;
+        return true;
+    }
+
+private:
+    size_t rank_;
+};
+
+size_t languageRank(std::string_view locale, const std::vector<std::string>& languages) {
+    if (locale.empty()) {
+        return languages.size();
+    }
+    for (size_t i = 0; i < languages.size(); ++i) {
+        if (languages[i] == locale) {
+            return i;
+        }
+    }
+    return languages.size() + 1; // Not wanted at all
+}
+
+void scanEntry(std::string_view content, const std::vector<std::string>& languages,
+               const std::vector<std::string>& current_desktops, DesktopEntry& entry) {
+    LocalizedValue name(languages.size()), generic_name(languages.size()),
+                   comment(languages.size()), keywords(languages.size());
+    bool in_group = false;
+    bool application = false;
+    bool hidden = false;
+    std::vector<std::string> only_show_in;
+    std::vector<std::string> not_show_in;
+
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = content.size();
+        }
+        std::string_view line = trimView(content.substr(pos, end - pos));
+        pos = end + 1;
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line[0] == '[') {
+            if (in_group) {
+                break; // Actions and other groups follow the entry, nothing more to read
+            }
+            in_group = line == DESKTOP_ENTRY_GROUP;
+            continue;
+        }
+        if (!in_group) {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = trimView(line.substr(0, equals));
+        std::string_view value = trimView(line.substr(equals + 1));
+
+        std::string_view locale;
+        size_t bracket = key.find('[');
+        if (bracket != std::string_view::npos && key.back() == ']') {
+            locale = key.substr(bracket + 1, key.size() - bracket - 2);
+            key = key.substr(0, bracket);
+        }
+        size_t rank = languageRank(locale, languages);
+        if (rank > languages.size()) {
+            continue;
+        }
+
+        if (key == "Name") {
+            if (name.offer(rank)) entry.name = unescapeValue(value, false);
+        } else if (key == "GenericName") {
+            if (generic_name.offer(rank)) entry.generic_name = unescapeValue(value, false);
+        } else if (key == "Comment") {
+            if (comment.offer(rank)) entry.comment = unescapeValue(value, false);
+        } else if (key == "Keywords") {
+            if (keywords.offer(rank)) entry.keywords = splitList(unescapeValue(value, true));
+        } else if (!locale.empty()) {
+            continue;
+        } else if (key == "Type") {
+            application = value == "Application";
+        } else if (key == "Exec") {
+            entry.exec = stripFieldCodes(unescapeValue(value, false));
+        } else if (key == "TryExec") {
+            entry.try_exec = unescapeValue(value, false);
+        } else if (key == "Icon") {
+            entry.icon = unescapeValue(value, false);
+        } else if (key == "Terminal") {
+            entry.terminal = value == "true";
+        } else if (key == "NoDisplay" || key == "Hidden") {
+            hidden = hidden || value == "true";
+        } else if (key == "OnlyShowIn") {
+            only_show_in = splitList(unescapeValue(value, true));
+        } else if (key == "NotShowIn") {
+            not_show_in = splitList(unescapeValue(value, true));
+        }
+    }
+
+    entry.visible = application && !hidden && !entry.name.empty() && !entry.exec.empty()
+        && (only_show_in.empty() || anyListed(only_show_in, current_desktops))
+        && !anyListed(not_show_in, current_desktops);
+}
+
+} // anonymous namespace
+
+bool parseDesktopEntry(const std::string& path, const std::vector<std::string>& languages,
+                       const std::vector<std::string>& current_desktops, DesktopEntry& entry) {
+    entry = DesktopEntry();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true; // Valid but empty, stays invisible
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    scanEntry(std::string_view(static_cast<const char*>(data), static_cast<size_t>(st.st_size)),
+              languages, current_desktops, entry);
+    munmap(data, static_cast<size_t>(st.st_size));
+    return true;
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PrimeCuts {
+
+// The keys of a .desktop file's [Desktop Entry] group that become an action
+struct DesktopEntry {
+    std::string name;
+    std::string generic_name;
+    std::string comment;
+    std::string exec;        // Field codes like %U are already removed
+    std::string icon;
+    std::string try_exec;
+    std::vector<std::string> keywords;
+    bool terminal = false;
+    bool visible = false;    // Type=Application, not NoDisplay/Hidden, shown in this desktop
+};
+
+// A parsed file and the file state it was parsed from; a rescan only reparses files
+// whose state differs
+struct CachedDesktopEntry {
+    int64_t mtime_ns = 0;
+    int64_t size = 0;
+    uint64_t inode = 0;
+    DesktopEntry entry;
+};
+
+// Keyed by the full path of the .desktop file
+using DesktopEntryCache = std::unordered_map<std::string, CachedDesktopEntry>;
+
+// Reads path with mmap and scans only the [Desktop Entry] group. Values are unescaped,
+// and the first of languages with a localized Name, GenericName, Comment or Keywords
+// wins over the plain key. Returns false if the file cannot be read.
+bool parseDesktopEntry(const std::string& path, const std::vector<std::string>& languages,
+                       const std::vector<std::string>& current_desktops, DesktopEntry& entry);
+
+} // namespace PrimeCuts
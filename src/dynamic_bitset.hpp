@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Fixed-size bit set sized at runtime, combined a 64-bit word at a time
+class DynamicBitset {
+public:
+    explicit DynamicBitset(size_t size = 0, bool value = false) {
+        assign(size, value);
+    }
+
+    void assign(size_t size, bool value) {
+        size_ = size;
+        words_.assign((size + 63) / 64, value ? ~uint64_t(0) : 0);
+        if (value && size % 64 != 0) {
+            words_.back() = (uint64_t(1) << (size % 64)) - 1;
+        }
+    }
+
+    size_t size() const { return size_; }
+    void set(size_t index) { words_[index / 64] |= uint64_t(1) << (index % 64); }
+    bool test(size_t index) const { return (words_[index / 64] >> (index % 64)) & 1; }
+
+    DynamicBitset& operator&=(const DynamicBitset& other) {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            words_[w] &= other.words_[w];
+        }
+        return *this;
+    }
+
+    bool none() const {
+        for (uint64_t word : words_) {
+            if (word != 0) return false;
+        }
+        return true;
+    }
+
+    // Calls f(index) for every set bit in increasing order, skipping empty words
+    template <typename F>
+    void forEachSet(F f) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            uint64_t word = words_[w];
+            while (word != 0) {
+                f(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
+
+} // namespace PrimeCuts
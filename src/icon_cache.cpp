@@ -0,0 +1,94 @@
+#include "icon_cache.hpp"
+#include "logger.hpp"
+#include <unordered_set>
+#include <vector>
+
+namespace PrimeCuts {
+
+IconCache::~IconCache() {
+    for (auto& [icon, variant] : icons_) {
+        if (variant) {
+            g_variant_unref(variant);
+        }
+    }
+}
+
+GVariant* IconCache::lookup(const std::string& icon) {
+    if (icon.empty()) {
+        return nullptr;
+    }
+    auto it = icons_.find(icon);
+    if (it == icons_.end()) {
+        it = icons_.emplace(icon, serialize(icon)).first;
+    }
+    return it->second;
+}
+
+void IconCache::prepare(const Config& config) {
+    for (const auto& group : config.groups) {
+        lookup(group.icon);
+        for (const auto& action : group.actions) {
+            lookup(action.icon);
+        }
+    }
+    LOG_DEBUG("Icon cache holds " + std::to_string(icons_.size()) + " icons");
+}
+
+void IconCache::prune(const Config& config) {
+    std::unordered_set<std::string> used;
+    for (const auto& group : config.groups) {
+        used.insert(group.icon);
+        for (const auto& action : group.actions) {
+            used.insert(action.icon);
+        }
+    }
+
+    for (auto it = icons_.begin(); it != icons_.end();) {
+        if (used.count(it->first) == 0) {
+            if (it->second) g_variant_unref(it->second);
+            it = icons_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+GVariant* IconCache::serialize(const std::string& icon) {
+    GIcon* gicon = nullptr;
+    if (icon[0] == '/' || icon.compare(0, 2, "~/") == 0 || icon.compare(0, 7, "file://") == 0) {
+        GFile* file = icon[0] == '~' ? g_file_new_for_path((std::string(g_get_home_dir()) + icon.substr(1)).c_str())
+            : icon[0] == '/' ? g_file_new_for_path(icon.c_str())
+            : g_file_new_for_uri(icon.c_str());
+        gicon = g_file_icon_new(file);
+        g_object_unref(file);
+    } else if (icon.find(',') != std::string::npos) {
+        std::vector<std::string> names;
+        size_t start = 0;
+        while (start <= icon.size()) {
+            size_t comma = icon.find(',', start);
+            std::string name = icon.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            if (!name.empty()) names.push_back(name);
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        if (names.empty()) {
+            return nullptr;
+        }
+        std::vector<char*> pointers;
+        for (auto& name : names) {
+            pointers.push_back(name.data());
+        }
+        gicon = g_themed_icon_new_from_names(pointers.data(), static_cast<int>(pointers.size()));
+    } else {
+        gicon = g_themed_icon_new_with_default_fallbacks(icon.c_str());
+    }
+
+    GVariant* serialized = g_icon_serialize(gicon);
+    g_object_unref(gicon);
+    if (!serialized) {
+        LOG_WARNING("Cannot serialize icon: " + icon);
+    }
+    return serialized;
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "config.hpp"
+#include <gio/gio.h>
+#include <string>
+#include <unordered_map>
+
+namespace PrimeCuts {
+
+// Serialized GIcon for each distinct icon of the actions, built once and sent as the
+// "icon" meta, so GNOME Shell does not parse the icon string again for every result.
+// An icon is one of:
+//   a themed icon name, falling back to shorter names ("network-server-symbolic", then "network-server")
+//   several names separated by ',', tried in order
+//   an image file: an absolute path, a path starting with "~/" or a file:// URI
+class IconCache {
+public:
+    IconCache() = default;
+    ~IconCache();
+
+    // Delete copy constructor and assignment operator
+    IconCache(const IconCache&) = delete;
+    IconCache& operator=(const IconCache&) = delete;
+
+    // Borrowed reference, nullptr for an empty icon. Icons not prepared are built here.
+    GVariant* lookup(const std::string& icon);
+    void prepare(const Config& config);
+    // Forgets icons that no action uses anymore; the others stay as they are
+    void prune(const Config& config);
+    size_t size() const { return icons_.size(); }
+
+private:
+    std::unordered_map<std::string, GVariant*> icons_;
+
+    static GVariant* serialize(const std::string& icon);
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,301 @@
+#include "json_reader.hpp"
+#include <cctype>
+
+namespace PrimeCuts {
+
+namespace {
+
+void appendUtf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        out += static_cast<char>(0xc0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+        out += static_cast<char>(0xe0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // anonymous namespace
+
+bool JsonReader::parse(JsonHandler& handler) {
+    pos_ = 0;
+    error_.clear();
+    skipWhitespace();
+    if (!parseValue(handler, 0)) {
+        return false;
+    }
+    skipWhitespace();
+    return pos_ == input_.size() || fail("Unexpected content after the document");
+}
+
+bool JsonReader::decodeString(std::string_view quoted, std::string& out) {
+    JsonReader reader(quoted);
+    std::string_view value;
+    if (quoted.empty() || quoted[0] != '"' || !reader.parseString(value) || reader.pos_ != quoted.size()) {
+        return false;
+    }
+    out.assign(value);
+    return true;
+}
+
+bool JsonReader::parseValue(JsonHandler& handler, size_t depth) {
+    if (pos_ >= input_.size()) {
+        return fail("Unexpected end of input");
+    }
+
+    switch (input_[pos_]) {
+        case '{':
+            return parseObject(handler, depth + 1);
+        case '[':
+            return parseArray(handler, depth + 1);
+        case '"': {
+            std::string_view value;
+            if (!parseString(value)) {
+                return false;
+            }
+            handler.string(value);
+            return true;
+        }
+        case 't':
+            if (!parseLiteral("true")) return false;
+            handler.boolean(true);
+            return true;
+        case 'f':
+            if (!parseLiteral("false")) return false;
+            handler.boolean(false);
+            return true;
+        case 'n':
+            if (!parseLiteral("null")) return false;
+            handler.null();
+            return true;
+        default:
+            return parseNumber(handler);
+    }
+}
+
+bool JsonReader::parseObject(JsonHandler& handler, size_t depth) {
+    if (depth > MAX_DEPTH) {
+        return fail("Nesting too deep");
+    }
+    pos_++; // '{'
+    handler.startObject();
+
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == '}') {
+        pos_++;
+        handler.endObject();
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        if (pos_ >= input_.size() || input_[pos_] != '"') {
+            return fail("Expected a key");
+        }
+        std::string_view name;
+        if (!parseString(name)) {
+            return false;
+        }
+        handler.key(name);
+
+        skipWhitespace();
+        if (pos_ >= input_.size() || input_[pos_] != ':') {
+            return fail("Expected ':'");
+        }
+        pos_++;
+        skipWhitespace();
+        if (!parseValue(handler, depth)) {
+            return false;
+        }
+
+        skipWhitespace();
+        if (pos_ < input_.size() && input_[pos_] == ',') {
+            pos_++;
+        } else if (pos_ < input_.size() && input_[pos_] == '}') {
+            pos_++;
+            handler.endObject();
+            return true;
+        } else {
+            return fail("Expected ',' or '}'");
+        }
+    }
+}
+
+bool JsonReader::parseArray(JsonHandler& handler, size_t depth) {
+    if (depth > MAX_DEPTH) {
+        return fail("Nesting too deep");
+    }
+    pos_++; // '['
+    handler.startArray();
+
+    skipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == ']') {
+        pos_++;
+        handler.endArray();
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        if (!parseValue(handler, depth)) {
+            return false;
+        }
+
+        skipWhitespace();
+        if (pos_ < input_.size() && input_[pos_] == ',') {
+            pos_++;
+        } else if (pos_ < input_.size() && input_[pos_] == ']') {
+            pos_++;
+            handler.endArray();
+            return true;
+        } else {
+            return fail("Expected ',' or ']'");
+        }
+    }
+}
+
+bool JsonReader::parseString(std::string_view& value) {
+    size_t start = ++pos_; // After the opening quote
+
+    // Fast path: no escapes, the value is a view into the input
+    while (pos_ < input_.size() && input_[pos_] != '"' && input_[pos_] != '\\') {
+        pos_++;
+    }
+    if (pos_ >= input_.size()) {
+        return fail("Unterminated string");
+    }
+    if (input_[pos_] == '"') {
+        value = input_.substr(start, pos_ - start);
+        pos_++;
+        return true;
+    }
+
+    scratch_.assign(input_.substr(start, pos_ - start));
+    while (pos_ < input_.size() && input_[pos_] != '"') {
+        char c = input_[pos_++];
+        if (c != '\\') {
+            scratch_ += c;
+            continue;
+        }
+        if (pos_ >= input_.size()) {
+            break;
+        }
+        char escape = input_[pos_++];
+        switch (escape) {
+            case '"': scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/': scratch_ += '/'; break;
+            case 'b': scratch_ += '\b'; break;
+            case 'f': scratch_ += '\f'; break;
+            case 'n': scratch_ += '\n'; break;
+            case 'r': scratch_ += '\r'; break;
+            case 't': scratch_ += '\t'; break;
+            case 'u': {
+                uint32_t code_point = 0;
+                if (!parseUnicodeEscape(code_point)) {
+                    return false;
+                }
+                appendUtf8(scratch_, code_point);
+                break;
+            }
+            default:
+                return fail(std::string("Invalid escape '\\") + escape + "'");
+        }
+    }
+    if (pos_ >= input_.size()) {
+        return fail("Unterminated string");
+    }
+    pos_++;
+    value = scratch_;
+    return true;
+}
+
+// The four hex digits after "\u", and a following low surrogate escape if this is a high one
+bool JsonReader::parseUnicodeEscape(uint32_t& code_point) {
+    auto readHex = [this](uint32_t& unit) {
+        if (pos_ + 4 > input_.size()) {
+            return false;
+        }
+        unit = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            int digit = hexValue(input_[pos_ + i]);
+            if (digit < 0) {
+                return false;
+            }
+            unit = unit * 16 + static_cast<uint32_t>(digit);
+        }
+        pos_ += 4;
+        return true;
+    };
+
+    if (!readHex(code_point)) {
+        return fail("Invalid \\u escape");
+    }
+    if (code_point >= 0xd800 && code_point < 0xdc00 && input_.substr(pos_, 2) == "\\u") {
+        size_t saved = pos_;
+        pos_ += 2;
+        uint32_t low = 0;
+        if (readHex(low) && low >= 0xdc00 && low < 0xe000) {
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+            return true;
+        }
+        pos_ = saved;
+    }
+    if (code_point >= 0xd800 && code_point < 0xe000) {
+        code_point = 0xfffd; // Unpaired surrogate
+    }
+    return true;
+}
+
+bool JsonReader::parseNumber(JsonHandler& handler) {
+    size_t start = pos_;
+    if (pos_ < input_.size() && input_[pos_] == '-') {
+        pos_++;
+    }
+    while (pos_ < input_.size() && (std::isdigit(static_cast<unsigned char>(input_[pos_])) ||
+           input_[pos_] == '.' || input_[pos_] == 'e' || input_[pos_] == 'E' || input_[pos_] == '+' || input_[pos_] == '-')) {
+        pos_++;
+    }
+    if (pos_ == start || !std::isdigit(static_cast<unsigned char>(input_[pos_ - 1]))) {
+        return fail("Invalid value");
+    }
+    handler.number(input_.substr(start, pos_ - start));
+    return true;
+}
+
+bool JsonReader::parseLiteral(std::string_view literal) {
+    if (input_.substr(pos_, literal.size()) != literal) {
+        return fail("Invalid value");
+    }
+    pos_ += literal.size();
+    return true;
+}
+
+void JsonReader::skipWhitespace() {
+    while (pos_ < input_.size() && (input_[pos_] == ' ' || input_[pos_] == '\t' ||
+           input_[pos_] == '\n' || input_[pos_] == '\r')) {
+        pos_++;
+    }
+}
+
+bool JsonReader::fail(const std::string& message) {
+    error_ = message + " at offset " + std::to_string(pos_);
+    return false;
+}
+
+} // namespace PrimeCuts
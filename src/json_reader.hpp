@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace PrimeCuts {
+
+// Receives the parts of a JSON document in order. Keys and strings are views that
+// are only valid during the call: into the input when the text has no escapes,
+// otherwise into a buffer of the reader that is reused for the next string.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void startObject() {}
+    virtual void endObject() {}
+    virtual void startArray() {}
+    virtual void endArray() {}
+    virtual void key(std::string_view /*name*/) {}
+    virtual void string(std::string_view /*value*/) {}
+    virtual void number(std::string_view /*text*/) {}  // As written, the handler converts what it needs
+    virtual void boolean(bool /*value*/) {}
+    virtual void null() {}
+};
+
+// Event based JSON reader: one pass over the input, no document tree and no copies
+// of unescaped strings
+class JsonReader {
+public:
+    static constexpr size_t MAX_DEPTH = 512;
+
+    explicit JsonReader(std::string_view input) : input_(input) {}
+
+    // Returns false on malformed input; error() then says what and where
+    bool parse(JsonHandler& handler);
+    const std::string& error() const { return error_; }
+
+    // Decodes one string token, quotes included, e.g. "a\"b" into a"b
+    static bool decodeString(std::string_view quoted, std::string& out);
+
+private:
+    std::string_view input_;
+    size_t pos_ = 0;
+    std::string scratch_;
+    std::string error_;
+
+    bool parseValue(JsonHandler& handler, size_t depth);
+    bool parseObject(JsonHandler& handler, size_t depth);
+    bool parseArray(JsonHandler& handler, size_t depth);
+    bool parseString(std::string_view& value);
+    bool parseNumber(JsonHandler& handler);
+    bool parseLiteral(std::string_view literal);
+    bool parseUnicodeEscape(uint32_t& code_point);
+    void skipWhitespace();
+    bool fail(const std::string& message);
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,103 @@
+#include "json_writer.hpp"
+
+namespace PrimeCuts {
+
+void JsonWriter::beginObject(bool inline_items) {
+    begin('{', inline_items);
+}
+
+void JsonWriter::endObject() {
+    end('}');
+}
+
+void JsonWriter::beginArray(bool inline_items) {
+    begin('[', inline_items);
+}
+
+void JsonWriter::endArray() {
+    end(']');
+}
+
+void JsonWriter::key(std::string_view name) {
+    beginValue();
+    writeQuoted(name);
+    file_.write(": ");
+    after_key_ = true;
+}
+
+void JsonWriter::string(std::string_view value) {
+    beginValue();
+    writeQuoted(value);
+}
+
+// Separator and indentation in front of a key, or of a value that has no key
+void JsonWriter::beginValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (levels_.empty()) {
+        return;
+    }
+
+    Level& level = levels_.back();
+    if (level.inline_items) {
+        if (level.count > 0) file_.write(", ");
+    } else {
+        if (level.count > 0) file_.write(",");
+        newline(levels_.size());
+    }
+    level.count++;
+}
+
+void JsonWriter::begin(char open, bool inline_items) {
+    beginValue();
+    file_.write(std::string_view(&open, 1));
+    // Everything inside an inline container stays on its line
+    bool parent_inline = !levels_.empty() && levels_.back().inline_items;
+    levels_.push_back({inline_items || parent_inline, 0});
+}
+
+void JsonWriter::end(char close) {
+    Level level = levels_.back();
+    levels_.pop_back();
+    if (!level.inline_items && level.count > 0) {
+        newline(levels_.size());
+    }
+    file_.write(std::string_view(&close, 1));
+}
+
+void JsonWriter::newline(size_t depth) {
+    scratch_.assign(1, '\n');
+    scratch_.append(depth * INDENT, ' ');
+    file_.write(scratch_);
+}
+
+void JsonWriter::writeQuoted(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    scratch_.assign(1, '"');
+    for (char c : text) {
+        switch (c) {
+            case '"': scratch_ += "\\\""; break;
+            case '\\': scratch_ += "\\\\"; break;
+            case '\n': scratch_ += "\\n"; break;
+            case '\r': scratch_ += "\\r"; break;
+            case '\t': scratch_ += "\\t"; break;
+            case '\b': scratch_ += "\\b"; break;
+            case '\f': scratch_ += "\\f"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    scratch_ += "\\u00";
+                    scratch_ += HEX[c >> 4];
+                    scratch_ += HEX[c & 0x0f];
+                } else {
+                    scratch_ += c;
+                }
+                break;
+        }
+    }
+    scratch_ += '"';
+    file_.write(scratch_);
+}
+
+} // namespace PrimeCuts
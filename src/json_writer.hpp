@@ -0,0 +1,52 @@
+#pragma once
+
+#include "atomic_file.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Writes indented JSON straight into an AtomicFile. Commas, indentation and string
+// escaping are handled here, so the same calls always produce the same bytes.
+// Inline containers are written on one line, e.g. ["a", "b"].
+class JsonWriter {
+public:
+    static constexpr size_t INDENT = 2;
+
+    explicit JsonWriter(AtomicFile& file) : file_(file) {}
+
+    void beginObject(bool inline_items = false);
+    void endObject();
+    void beginArray(bool inline_items = false);
+    void endArray();
+    void key(std::string_view name);
+    void string(std::string_view value);
+
+    void member(std::string_view name, std::string_view value) {
+        key(name);
+        string(value);
+    }
+
+    // Ends the document with a newline
+    void finish() { file_.write("\n"); }
+
+private:
+    struct Level {
+        bool inline_items;
+        size_t count;
+    };
+
+    AtomicFile& file_;
+    std::vector<Level> levels_;
+    bool after_key_ = false;
+    std::string scratch_;
+
+    void beginValue();
+    void begin(char open, bool inline_items);
+    void end(char close);
+    void newline(size_t depth);
+    void writeQuoted(std::string_view text);
+};
+
+} // namespace PrimeCuts
@@ -64,7 +64,8 @@ private:
     bool debug_enabled_ = false;
 };
 
-#define LOG_DEBUG(msg) PrimeCuts::Logger::getInstance().debug(msg)
+// The message is only built when debug output is on
+#define LOG_DEBUG(msg) do { if (PrimeCuts::Logger::getInstance().isDebugEnabled()) PrimeCuts::Logger::getInstance().debug(msg); } while (0)
 #define LOG_INFO(msg) PrimeCuts::Logger::getInstance().info(msg)
 #define LOG_WARNING(msg) PrimeCuts::Logger::getInstance().warning(msg)
 #define LOG_ERROR(msg) PrimeCuts::Logger::getInstance().error(msg)
@@ -1,16 +1,67 @@
 #include <gio/gio.h>
+#include <glib-unix.h>
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
 
 #include "config.hpp"
 #include "config_loader.hpp"
 #include "command_manager.hpp"
+#include "action_source.hpp"
+#include "benchmark.hpp"
+#include "cli.hpp"
+#include "icon_cache.hpp"
+#include "request_arena.hpp"
+#include "result_metas.hpp"
+#include "search_coalescer.hpp"
+#include "trace.hpp"
+#include "warm_snapshot.hpp"
 #include "logger.hpp"
 #include "constants.hpp"
 
 static std::unique_ptr<PrimeCuts::CommandManager> command_manager;
-static PrimeCuts::Config app_config;
+static std::unique_ptr<PrimeCuts::SourceManager> source_manager;
+static PrimeCuts::IconCache icon_cache; // Filled by the loader thread, then only used on the main thread
+
+// Startup state: the bus name is owned before the config is parsed and indexed
+static GMainLoop* main_loop = nullptr;
+static gint64 startup_time = 0;
+static bool first_answer_logged = false;
+static bool startup_failed = false;
+static std::mutex fallback_mutex;
+static std::shared_ptr<const PrimeCuts::Config> fallback_config; // Parsed config, until the index is ready
+static std::vector<GDBusMethodInvocation*> pending_activations;
+static std::unique_ptr<PrimeCuts::TraceRecorder> trace_recorder; // Only with --record-trace
+static std::unique_ptr<PrimeCuts::SearchCoalescer> search_coalescer; // Only with coalesce_window_ms
+
+// conf.d reloads: the loader keeps each file's content hash, one reload runs at a time
+static PrimeCuts::ConfigLoader config_loader;
+static GFileMonitor* fragment_monitor = nullptr;
+static bool fragment_reload_running = false;
+static bool fragment_reload_pending = false;
+static gint64 fragment_reload_start = 0;
+
+// Warm start: hot queries are answered from the snapshot until the index is ready
+static std::shared_ptr<const PrimeCuts::WarmSnapshot> warm_snapshot; // Mapped by the loader thread, until the index is ready
+static bool warm_results_valid = false; // Written with the config files the snapshot describes
+static PrimeCuts::QueryCounter query_counter;
+static size_t config_hash = 0; // Of the config files the running index was built from; first set by the loader thread
+static guint snapshot_timer = 0;
+static bool snapshot_write_running = false;
+static bool remember_queries = true; // remember_queries setting; false counts nothing and keeps no snapshot
+
+// Idle exit: D-Bus activation starts the service again for the next search
+static guint idle_timeout_seconds = 0; // 0 = run until the session ends
+static guint idle_timer = 0;
+static gint64 last_call_time = 0;
 
 const char* introspection_xml =
     "<node>"
@@ -38,33 +89,272 @@ const char* introspection_xml =
 
 namespace {
 
-bool parseCommandLineArgs(int argc, char* argv[]) {
+struct CommandLineOptions {
+    bool debug_mode = false;
+    size_t benchmark_actions = 0; // Run the shard benchmark instead of the service
+    PrimeCuts::HeadlessOptions headless;
+    std::string record_trace;      // Write every incoming call to this file
+    bool anonymize_trace = false;
+    std::string replay_trace;      // Replay this file in-process instead of serving D-Bus
+    bool replay_original_speed = false;
+};
+
+CommandLineOptions parseCommandLineArgs(int argc, char* argv[]) {
+    CommandLineOptions options;
     for (int i = 1; i < argc; i++) {
-        if (std::string(argv[i]) == PrimeCuts::Constants::ARG_DEBUG) {
+        std::string arg = argv[i];
+        if (arg == PrimeCuts::Constants::ARG_DEBUG) {
             PrimeCuts::Logger::getInstance().setDebugMode(true);
-            return true;
+            options.debug_mode = true;
+        } else if (arg == PrimeCuts::Constants::ARG_BENCHMARK_SHARDS) {
+            options.benchmark_actions = PrimeCuts::Constants::DEFAULT_BENCHMARK_ACTIONS;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                options.benchmark_actions = std::strtoul(argv[++i], nullptr, 10);
+            }
+        } else if (arg == PrimeCuts::Constants::ARG_QUERY && i + 1 < argc) {
+            options.headless.query = argv[++i];
+        } else if (arg == PrimeCuts::Constants::ARG_BATCH && i + 1 < argc) {
+            options.headless.batch_file = argv[++i];
+        } else if (arg == PrimeCuts::Constants::ARG_ITERATIONS && i + 1 < argc) {
+            options.headless.iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == PrimeCuts::Constants::ARG_METAS) {
+            options.headless.with_metas = true;
+        } else if (arg == PrimeCuts::Constants::ARG_ALLOC_BUDGET && i + 1 < argc) {
+            options.headless.alloc_budget = std::strtoul(argv[++i], nullptr, 10);
+            options.headless.check_allocations = true;
+        } else if (arg == PrimeCuts::Constants::ARG_CONFIG && i + 1 < argc) {
+            options.headless.config_path = argv[++i];
+        } else if (arg == PrimeCuts::Constants::ARG_RECORD_TRACE && i + 1 < argc) {
+            options.record_trace = argv[++i];
+        } else if (arg == PrimeCuts::Constants::ARG_ANONYMIZE_TRACE) {
+            options.anonymize_trace = true;
+        } else if (arg == PrimeCuts::Constants::ARG_REPLAY && i + 1 < argc) {
+            options.replay_trace = argv[++i];
+        } else if (arg == PrimeCuts::Constants::ARG_REPLAY_SPEED && i + 1 < argc) {
+            options.replay_original_speed = std::string(argv[++i]) == PrimeCuts::Constants::REPLAY_SPEED_ORIGINAL;
         }
     }
-    return false;
+    return options;
 }
 
-bool initializeConfiguration() {
-    PrimeCuts::ConfigLoader loader;
+double millisecondsSinceStartup() {
+    return (g_get_monotonic_time() - startup_time) / 1000.0;
+}
+
+void logFirstAnswer(const char* source) {
+    if (!first_answer_logged) {
+        first_answer_logged = true;
+        LOG_INFO("First search answered " + std::to_string(millisecondsSinceStartup()) + " ms after startup (" + source + ")");
+    }
+}
+
+std::shared_ptr<const PrimeCuts::Config> getFallbackConfig() {
+    std::lock_guard<std::mutex> lock(fallback_mutex);
+    return fallback_config;
+}
+
+// Null unless the snapshot was written for the current config files
+std::shared_ptr<const PrimeCuts::WarmSnapshot> getWarmSnapshot() {
+    std::lock_guard<std::mutex> lock(fallback_mutex);
+    return warm_results_valid ? warm_snapshot : nullptr;
+}
+
+// Runs in a worker thread so the bus name can be owned without waiting for the config
+void loadConfigurationThread(GTask* task, gpointer source_object, gpointer task_data, GCancellable* cancellable) {
+    // The snapshot is mapped before the config is parsed; its results are only trusted
+    // for the config files it was written with, its query counts always carry over
+    config_hash = config_loader.hashConfigFiles("");
+    auto snapshot = std::make_shared<PrimeCuts::WarmSnapshot>();
+    if (snapshot->load(PrimeCuts::WarmSnapshot::defaultPath())) {
+        bool valid = snapshot->configHash() == config_hash;
+        if (!valid) {
+            LOG_DEBUG("Config changed since the warm snapshot was written, not using its results");
+        }
+        std::lock_guard<std::mutex> lock(fallback_mutex);
+        warm_snapshot = std::move(snapshot);
+        warm_results_valid = valid;
+    }
+    
+    auto config = std::make_shared<PrimeCuts::Config>();
     
     // Try to load configuration, create default if not found
-    if (!loader.loadConfig("", app_config)) {
+    if (!config_loader.loadConfig("", *config)) {
+        g_task_return_pointer(task, nullptr, nullptr);
+        return;
+    }
+    
+    // Early queries can already be answered by scanning the parsed config
+    {
+        std::lock_guard<std::mutex> lock(fallback_mutex);
+        fallback_config = config;
+    }
+    LOG_DEBUG("Configuration parsed after " + std::to_string(millisecondsSinceStartup()) + " ms, building search index...");
+    
+    auto* manager = new PrimeCuts::CommandManager(*config);
+    icon_cache.prepare(*config);
+    g_task_return_pointer(task, manager, [](gpointer data) { delete static_cast<PrimeCuts::CommandManager*>(data); });
+}
+
+GVariant* handleActivateResult(GVariant* parameters);
+GVariant* dispatchMethod(const gchar* method_name, GVariant* parameters);
+void watchConfigFragments();
+
+// What a snapshot write needs from the main loop, taken when it starts
+struct SnapshotJob {
+    size_t config_hash = 0;
+    PrimeCuts::WarmSnapshot::HotQueries queries;
+    uint32_t next_session_id = 0;
+};
+
+bool runSnapshotJob(SnapshotJob& job) {
+    return PrimeCuts::WarmSnapshot::write(PrimeCuts::WarmSnapshot::defaultPath(), job.config_hash, *command_manager,
+                                          std::move(job.queries), job.next_session_id);
+}
+
+// Ranking up to 256 queries takes long enough to delay searches, so it runs in a worker thread
+void writeSnapshotThread(GTask* task, gpointer source_object, gpointer task_data, GCancellable* cancellable) {
+    g_task_return_boolean(task, runSnapshotJob(*static_cast<SnapshotJob*>(task_data)));
+}
+
+void onSnapshotWritten(GObject* source_object, GAsyncResult* result, gpointer user_data) {
+    snapshot_write_running = false;
+    g_task_propagate_boolean(G_TASK(result), nullptr);
+}
+
+// In the background on the timer; on shutdown on the main thread, once a running write is done
+void writeWarmSnapshot(bool in_background) {
+    if (!in_background) {
+        while (snapshot_write_running) {
+            g_main_context_iteration(nullptr, TRUE);
+        }
+    }
+    if (!command_manager || !remember_queries || !query_counter.changed() || snapshot_write_running) {
+        return;
+    }
+    
+    auto* job = new SnapshotJob();
+    job->config_hash = config_hash;
+    job->queries = query_counter.mostFrequent(PrimeCuts::Constants::SNAPSHOT_HOT_QUERIES);
+    job->next_session_id = command_manager->nextSessionId();
+    query_counter.clearChanged();
+    
+    if (!in_background) {
+        runSnapshotJob(*job);
+        delete job;
+        return;
+    }
+    snapshot_write_running = true;
+    GTask* task = g_task_new(nullptr, nullptr, onSnapshotWritten, nullptr);
+    g_task_set_task_data(task, job, [](gpointer data) { delete static_cast<SnapshotJob*>(data); });
+    g_task_run_in_thread(task, writeSnapshotThread);
+    g_object_unref(task);
+}
+
+gboolean onSnapshotTimer(gpointer user_data) {
+    writeWarmSnapshot(true);
+    return G_SOURCE_CONTINUE;
+}
+
+size_t residentKilobytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+// Armed for the time left until the timeout instead of being restarted on every call
+gboolean onIdleCheck(gpointer user_data) {
+    gint64 idle_seconds = (g_get_monotonic_time() - last_call_time) / G_USEC_PER_SEC;
+    if (idle_seconds < idle_timeout_seconds || fragment_reload_running) {
+        guint remaining = idle_seconds < idle_timeout_seconds ? idle_timeout_seconds - static_cast<guint>(idle_seconds) : 1;
+        idle_timer = g_timeout_add_seconds(remaining, onIdleCheck, nullptr);
+        return G_SOURCE_REMOVE;
+    }
+    
+    idle_timer = 0;
+    LOG_INFO("No calls for " + std::to_string(idle_timeout_seconds / 60) + " minutes, exiting and releasing "
+             + std::to_string(residentKilobytes()) + " kB resident memory");
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean onQuitSignal(gpointer user_data) {
+    LOG_INFO("Shutting down...");
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_CONTINUE;
+}
+
+void onConfigurationLoaded(GObject* source_object, GAsyncResult* result, gpointer user_data) {
+    auto* manager = static_cast<PrimeCuts::CommandManager*>(g_task_propagate_pointer(G_TASK(result), nullptr));
+    if (!manager) {
         LOG_ERROR("Failed to load configuration");
-        return false;
+        startup_failed = true;
+        // Activations queued during startup can never run, answer them instead of letting them time out
+        for (auto* invocation : pending_activations) {
+            g_dbus_method_invocation_return_dbus_error(invocation, PrimeCuts::Constants::DBUS_ERROR_FAILED,
+                                                       "PrimeCuts could not load its configuration");
+            g_object_unref(invocation);
+        }
+        pending_activations.clear();
+        g_main_loop_quit(main_loop);
+        return;
+    }
+    
+    command_manager.reset(manager);
+    // The command manager keeps the only copy of the config once the fallback is released
+    const PrimeCuts::Config& config = command_manager->config();
+    
+    // Query counts and virtual result ids continue from the previous run; the snapshot is not needed anymore
+    std::shared_ptr<const PrimeCuts::WarmSnapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(fallback_mutex);
+        snapshot.swap(warm_snapshot);
+        warm_results_valid = false;
+    }
+    auto remember_it = config.global_settings.find(PrimeCuts::Constants::SETTING_REMEMBER_QUERIES);
+    remember_queries = remember_it == config.global_settings.end() || remember_it->second != "false";
+    if (snapshot) {
+        if (remember_queries) {
+            snapshot->restoreCounts(query_counter);
+        }
+        command_manager->resumeSessions(snapshot->nextSessionId());
+    }
+    if (remember_queries) {
+        snapshot_timer = g_timeout_add_seconds(PrimeCuts::Constants::SNAPSHOT_INTERVAL_SECONDS, onSnapshotTimer, nullptr);
+    } else if (unlink(PrimeCuts::WarmSnapshot::defaultPath().c_str()) == 0) {
+        LOG_INFO("Queries are not remembered, removed the warm snapshot");
     }
     
-    // Initialize command manager with the loaded config
-    command_manager = std::make_unique<PrimeCuts::CommandManager>(app_config);
+    // Generated actions come from the cache right away, generators run in the background
+    source_manager = std::make_unique<PrimeCuts::SourceManager>(*command_manager, config);
+    source_manager->start();
+    
+    auto window_it = config.global_settings.find(PrimeCuts::Constants::SETTING_COALESCE_WINDOW_MS);
+    guint coalesce_window = window_it != config.global_settings.end() ? std::strtoul(window_it->second.c_str(), nullptr, 10) : 0;
+    if (coalesce_window > 0) {
+        search_coalescer = std::make_unique<PrimeCuts::SearchCoalescer>(coalesce_window, dispatchMethod);
+        LOG_DEBUG("Coalescing searches within " + std::to_string(coalesce_window) + " ms");
+    }
     
-    LOG_DEBUG("Configuration loaded successfully with " + std::to_string(app_config.groups.size()) + " groups");
+    auto idle_it = config.global_settings.find(PrimeCuts::Constants::SETTING_IDLE_TIMEOUT_MINUTES);
+    idle_timeout_seconds = idle_it != config.global_settings.end() ? std::strtoul(idle_it->second.c_str(), nullptr, 10) * 60 : 0;
+    if (idle_timeout_seconds > 0) {
+        idle_timer = g_timeout_add_seconds(idle_timeout_seconds, onIdleCheck, nullptr);
+        LOG_DEBUG("Exiting after " + std::to_string(idle_timeout_seconds / 60) + " minutes without calls");
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(fallback_mutex);
+        fallback_config.reset();
+    }
+    
+    LOG_INFO("Search index ready after " + std::to_string(millisecondsSinceStartup()) + " ms with "
+             + std::to_string(config.groups.size()) + " action groups");
     
     // Print loaded actions for debugging
     if (PrimeCuts::Logger::getInstance().isDebugEnabled()) {
-        for (const auto& group : app_config.groups) {
+        for (const auto& group : config.groups) {
             LOG_DEBUG("Group: " + group.name + " (" + std::to_string(group.actions.size()) + " actions)");
             for (const auto& action : group.actions) {
                 LOG_DEBUG("  - " + action.name + " [" + action.id + "]");
@@ -72,55 +362,213 @@ bool initializeConfiguration() {
         }
     }
     
-    return true;
+    // Activations that arrived during startup need the command manager to run
+    for (auto* invocation : pending_activations) {
+        GVariant* reply = handleActivateResult(g_dbus_method_invocation_get_parameters(invocation));
+        g_dbus_method_invocation_return_value(invocation, reply);
+        g_object_unref(invocation);
+    }
+    pending_activations.clear();
+    
+    watchConfigFragments();
+}
+
+// Groups with an action source are owned by the SourceManager, which is set up at startup
+void applyFragmentChanges(PrimeCuts::FragmentChanges& changes) {
+    auto has_source = [](const PrimeCuts::Group* group) { return group && group->source; };
+    
+    // Collected first, so the search index is updated once for the whole reload
+    std::vector<std::string> removed_groups;
+    for (auto& name : changes.removed_groups) {
+        if (has_source(command_manager->findGroup(name))) {
+            LOG_INFO("Group '" + name + "' has an action source, removing it takes effect after a restart");
+        } else {
+            removed_groups.push_back(std::move(name));
+        }
+    }
+    std::vector<PrimeCuts::Group> updated_groups;
+    for (auto& group : changes.updated_groups) {
+        if (group.source || has_source(command_manager->findGroup(group.name))) {
+            LOG_INFO("Group '" + group.name + "' has an action source, changes to it take effect after a restart");
+            continue;
+        }
+        updated_groups.push_back(std::move(group));
+    }
+    size_t patched = command_manager->applyGroupChanges(removed_groups, std::move(updated_groups));
+    
+    icon_cache.prune(command_manager->config());
+    LOG_INFO("Reloaded " + std::to_string(changes.files_parsed) + " config files and updated "
+             + std::to_string(patched) + " groups in " + std::to_string((g_get_monotonic_time() - fragment_reload_start) / 1000.0) + " ms");
+}
+
+struct FragmentReload {
+    PrimeCuts::FragmentChanges changes;
+    size_t config_hash = 0;
+};
+
+void fragmentReloadThread(GTask* task, gpointer source_object, gpointer task_data, GCancellable* cancellable) {
+    auto* reload = new FragmentReload();
+    // Hashed before reading: a file saved in between leaves the hash older than the parsed
+    // groups, so the next start sees different files and discards the snapshot instead of
+    // trusting results that may not match them
+    reload->config_hash = config_loader.hashConfigFiles("");
+    reload->changes = config_loader.reloadFragments(config_loader.getFragmentDirectory(""));
+    g_task_return_pointer(task, reload, [](gpointer data) { delete static_cast<FragmentReload*>(data); });
+}
+
+void scheduleFragmentReload();
+
+void onFragmentsReloaded(GObject* source_object, GAsyncResult* result, gpointer user_data) {
+    std::unique_ptr<FragmentReload> reload(static_cast<FragmentReload*>(g_task_propagate_pointer(G_TASK(result), nullptr)));
+    fragment_reload_running = false;
+    
+    if (reload) {
+        config_hash = reload->config_hash;
+    }
+    if (reload && !reload->changes.empty()) {
+        applyFragmentChanges(reload->changes);
+    } else {
+        LOG_DEBUG("Config directory changed, no group changed");
+    }
+    
+    if (fragment_reload_pending) {
+        scheduleFragmentReload();
+    }
+}
+
+// Only changed files are read and parsed, in a worker thread; the groups are patched here
+void scheduleFragmentReload() {
+    if (fragment_reload_running) {
+        fragment_reload_pending = true;
+        return;
+    }
+    fragment_reload_running = true;
+    fragment_reload_pending = false;
+    fragment_reload_start = g_get_monotonic_time();
+    
+    GTask* task = g_task_new(nullptr, nullptr, onFragmentsReloaded, nullptr);
+    g_task_run_in_thread(task, fragmentReloadThread);
+    g_object_unref(task);
+}
+
+void onFragmentDirectoryChanged(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                                GFileMonitorEvent event_type, gpointer user_data) {
+    if (event_type == G_FILE_MONITOR_EVENT_CHANGED) {
+        return; // Wait for CHANGES_DONE_HINT instead of reacting to every write
+    }
+    scheduleFragmentReload();
+}
+
+void watchConfigFragments() {
+    std::string directory = config_loader.getFragmentDirectory("");
+    GFile* file = g_file_new_for_path(directory.c_str());
+    GError* error = nullptr;
+    fragment_monitor = g_file_monitor(file, G_FILE_MONITOR_NONE, nullptr, &error);
+    g_object_unref(file);
+    
+    if (!fragment_monitor) {
+        LOG_WARNING("Cannot watch config directory " + directory + ": " + std::string(error ? error->message : "Unknown error"));
+        if (error) g_error_free(error);
+        return;
+    }
+    
+    g_file_monitor_set_rate_limit(fragment_monitor, 500);
+    g_signal_connect(fragment_monitor, "changed", G_CALLBACK(onFragmentDirectoryChanged), nullptr);
+}
+
+PrimeCuts::ResultIds fallbackSearch(PrimeCuts::TermSpan terms, std::pmr::memory_resource* memory) {
+    PrimeCuts::ResultIds matches(memory);
+    auto config = getFallbackConfig();
+    if (!config) {
+        LOG_DEBUG("Configuration not loaded yet, returning no results");
+        return matches;
+    }
+    
+    std::vector<std::string> folded_terms;
+    for (const auto& term : terms) {
+        if (!term.empty()) {
+            folded_terms.push_back(PrimeCuts::SearchIndex::fold(term));
+        }
+    }
+    
+    auto it = config->global_settings.find(PrimeCuts::Constants::SETTING_MAX_RESULTS);
+    size_t max_results = it != config->global_settings.end() ? std::strtoul(it->second.c_str(), nullptr, 10) : 0;
+    PrimeCuts::MatchMode match_mode = PrimeCuts::MatchMode::ANY;
+    auto mode_it = config->global_settings.find(PrimeCuts::Constants::SETTING_MATCH_MODE);
+    if (mode_it != config->global_settings.end()) {
+        PrimeCuts::SearchIndex::parseMatchMode(mode_it->second, match_mode);
+    }
+    for (const auto& hit : PrimeCuts::SearchIndex::scan(*config, folded_terms, max_results, match_mode)) {
+        matches.emplace_back(hit.action->id);
+    }
+    return matches;
 }
 
-std::vector<std::string> extractSearchTerms(GVariant* parameters, const std::string& method_name) {
-    std::vector<std::string> search_terms;
+// Borrows the terms from the message without copying; valid while parameters is alive
+std::pmr::vector<std::string_view> extractSearchTerms(GVariant* parameters, const gchar* method_name,
+                                                      std::pmr::memory_resource* memory) {
+    std::pmr::vector<std::string_view> search_terms(memory);
     
-    LOG_DEBUG("Processing " + method_name + " request...");
+    LOG_DEBUG("Processing " + std::string(method_name) + " request...");
     LOG_DEBUG("Parameters type: " + std::string(g_variant_get_type_string(parameters)));
     
-    GVariantIter iter;
-    g_variant_iter_init(&iter, parameters);
+    const gchar** terms = nullptr;
     
     // For GetSubsearchResultSet, skip the first parameter (previous results)
-    if (method_name == PrimeCuts::Constants::METHOD_GET_SUBSEARCH_RESULT_SET) {
-        GVariant* previous_results = g_variant_iter_next_value(&iter);
-        if (previous_results) {
-            LOG_DEBUG("Previous results count: " + std::to_string(g_variant_n_children(previous_results)));
-            g_variant_unref(previous_results);
-        }
+    if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0) {
+        GVariant* previous_results = nullptr;
+        g_variant_get(parameters, "(@as^a&s)", &previous_results, &terms);
+        LOG_DEBUG("Previous results count: " + std::to_string(g_variant_n_children(previous_results)));
+        g_variant_unref(previous_results);
+    } else {
+        g_variant_get(parameters, "(^a&s)", &terms);
     }
     
-    // Get the terms array
-    GVariant* terms_array = g_variant_iter_next_value(&iter);
-    
-    if (terms_array) {
-        LOG_DEBUG("Terms array size: " + std::to_string(g_variant_n_children(terms_array)));
-        
-        GVariantIter terms_iter;
-        g_variant_iter_init(&terms_iter, terms_array);
-        
-        gchar* term;
-        while (g_variant_iter_next(&terms_iter, "s", &term)) {
-            std::string termStr(term);
-            LOG_DEBUG("Search term: '" + termStr + "' (length: " + std::to_string(termStr.length()) + ")");
-            search_terms.push_back(termStr);
-            g_free(term);
-        }
-        g_variant_unref(terms_array);
+    for (const gchar** term = terms; term && *term; ++term) {
+        search_terms.emplace_back(*term);
     }
+    g_free(terms);
     
-    LOG_DEBUG("Total search terms extracted: " + std::to_string(search_terms.size()));
+    if (PrimeCuts::Logger::getInstance().isDebugEnabled()) {
+        for (const auto& term : search_terms) {
+            LOG_DEBUG("Search term: '" + std::string(term) + "' (length: " + std::to_string(term.size()) + ")");
+        }
+        LOG_DEBUG("Total search terms extracted: " + std::to_string(search_terms.size()));
+    }
     return search_terms;
 }
 
-void handleSearchRequest(GDBusMethodInvocation* invocation, GVariant* parameters, const std::string& method_name) {
-    std::vector<std::string> search_terms = extractSearchTerms(parameters, method_name);
+GVariant* handleSearchRequest(GVariant* parameters, const gchar* method_name) {
+    std::pmr::memory_resource* memory = PrimeCuts::RequestArena::forThread().resource();
+    std::pmr::vector<std::string_view> search_terms = extractSearchTerms(parameters, method_name, memory);
+    PrimeCuts::TermSpan terms(search_terms.data(), search_terms.size());
     
-    // Use command manager to search for matching actions
-    std::vector<std::string> matches = command_manager->searchActions(search_terms);
+    std::pmr::string query_key = PrimeCuts::WarmSnapshot::queryKey(terms, memory);
+    if (remember_queries) {
+        query_counter.record(query_key);
+    }
+    
+    // Use command manager to search for matching actions; during startup a hot query is
+    // answered from the warm snapshot, any other one by scanning whatever has loaded so far
+    PrimeCuts::ResultIds matches(memory);
+    const char* answered_by = "search index";
+    if (command_manager) {
+        matches = command_manager->searchActions(terms, memory);
+    } else {
+        auto snapshot = getWarmSnapshot();
+        if (snapshot && snapshot->lookup(query_key, matches)) {
+            answered_by = "warm snapshot";
+        } else {
+            matches = fallbackSearch(terms, memory);
+            answered_by = "fallback scan";
+        }
+        // The same virtual actions as the index appends, without a session yet
+        if (!terms.empty()) {
+            matches.emplace_back(PrimeCuts::Constants::SEARCH_GOOGLE_ID);
+            matches.emplace_back(PrimeCuts::Constants::SEARCH_CHATGPT_ID);
+        }
+    }
+    logFirstAnswer(answered_by);
     
     LOG_DEBUG("Search completed. Found " + std::to_string(matches.size()) + " matching actions");
 
@@ -128,52 +576,28 @@ void handleSearchRequest(GDBusMethodInvocation* invocation, GVariant* parameters
     g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
     for (const auto& id : matches) {
         g_variant_builder_add(&builder, "s", id.c_str());
-        LOG_DEBUG("Found match: " + id);
+        LOG_DEBUG("Found match: " + std::string(id));
     }
 
     LOG_DEBUG("Returning " + std::to_string(matches.size()) + " results");
-    g_dbus_method_invocation_return_value(invocation, g_variant_new("(as)", &builder));
+    return g_variant_new("(as)", &builder);
 }
 
-void handleGetResultMetas(GDBusMethodInvocation* invocation, GVariant* parameters) {
+GVariant* handleGetResultMetas(GVariant* parameters) {
     LOG_DEBUG("Processing GetResultMetas request...");
     
-    GVariantIter iter;
-    g_variant_iter_init(&iter, parameters);
-    GVariant* ids_array = g_variant_iter_next_value(&iter);
-
-    GVariantBuilder outer;
-    g_variant_builder_init(&outer, G_VARIANT_TYPE("aa{sv}"));
-
-    if (ids_array) {
-        GVariantIter ids_iter;
-        g_variant_iter_init(&ids_iter, ids_array);
-        
-        gchar* id;
-        while (g_variant_iter_next(&ids_iter, "s", &id)) {
-            LOG_DEBUG("Getting meta for ID: " + std::string(id));
-            const PrimeCuts::Action* action = command_manager->getAction(id);
-            if (action) {
-                GVariantBuilder meta;
-                g_variant_builder_init(&meta, G_VARIANT_TYPE("a{sv}"));
-                g_variant_builder_add(&meta, "{sv}", "id", g_variant_new_string(id));
-                g_variant_builder_add(&meta, "{sv}", "name", g_variant_new_string(action->name.c_str()));
-                g_variant_builder_add(&meta, "{sv}", "description", g_variant_new_string(action->description.c_str()));
-                g_variant_builder_add(&meta, "{sv}", "icon", g_variant_new_string(action->icon.c_str()));
-
-                g_variant_builder_add(&outer, "a{sv}", &meta);
-            } else {
-                LOG_DEBUG("No action found for ID: " + std::string(id));
-            }
-            g_free(id);
-        }
-        g_variant_unref(ids_array);
-    }
-
-    g_dbus_method_invocation_return_value(invocation, g_variant_new("(aa{sv})", &outer));
+    // Keeps the fallback config and the snapshot alive while their actions are referenced
+    auto loading_config = command_manager ? nullptr : getFallbackConfig();
+    auto snapshot = command_manager ? nullptr : getWarmSnapshot();
+    PrimeCuts::MetaSources sources;
+    sources.manager = command_manager.get();
+    sources.icons = &icon_cache;
+    sources.loading_config = loading_config.get();
+    sources.snapshot = snapshot.get();
+    return PrimeCuts::buildResultMetas(parameters, sources);
 }
 
-void handleActivateResult(GDBusMethodInvocation* invocation, GVariant* parameters) {
+GVariant* handleActivateResult(GVariant* parameters) {
     LOG_DEBUG("Processing ActivateResult request...");
     
     const gchar* id;
@@ -183,26 +607,40 @@ void handleActivateResult(GDBusMethodInvocation* invocation, GVariant* parameter
 
     LOG_DEBUG("Activating result with ID: " + std::string(id));
     
-    // Extract terms for potential use in command execution
-    std::vector<std::string> terms;
-    if (terms_variant) {
-        GVariantIter terms_iter;
-        g_variant_iter_init(&terms_iter, terms_variant);
-        gchar* term;
-        while (g_variant_iter_next(&terms_iter, "s", &term)) {
-            terms.push_back(std::string(term));
-            g_free(term);
-        }
-        g_variant_unref(terms_variant);
-    }
+    // Borrow terms for potential use in command execution
+    std::vector<std::string_view> terms;
+    gsize term_count = 0;
+    const gchar** term_strings = g_variant_get_strv(terms_variant, &term_count);
+    terms.assign(term_strings, term_strings + term_count);
+    g_free(term_strings);
     
     // Use command manager to execute the action
     bool success = command_manager->executeAction(id, terms);
+    g_variant_unref(terms_variant);
     if (!success) {
         LOG_DEBUG("Failed to execute action with ID: " + std::string(id));
     }
 
-    g_dbus_method_invocation_return_value(invocation, nullptr);
+    return nullptr;
+}
+
+// Computes the reply for one method call; shared by the D-Bus handler and trace replay.
+// The reply is built by GLib, so the request arena is free again once it is returned.
+GVariant* dispatchMethod(const gchar* method_name, GVariant* parameters) {
+    PrimeCuts::RequestArena::Scope request;
+    if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_INITIAL_RESULT_SET) == 0 ||
+        g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0) {
+        return handleSearchRequest(parameters, method_name);
+    }
+    else if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_RESULT_METAS) == 0) {
+        return handleGetResultMetas(parameters);
+    }
+    else if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_ACTIVATE_RESULT) == 0) {
+        return handleActivateResult(parameters);
+    }
+    
+    LOG_DEBUG("Unknown method called: " + std::string(method_name));
+    return nullptr;
 }
 
 static void handle_method_call(
@@ -216,21 +654,25 @@ static void handle_method_call(
     gpointer user_data) 
 {
     LOG_DEBUG("DBus method called: " + std::string(method_name) + " from " + std::string(sender));
+    last_call_time = g_get_monotonic_time();
     
-    if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_INITIAL_RESULT_SET) == 0 ||
-        g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0) {
-        handleSearchRequest(invocation, parameters, method_name);
-    }
-    else if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_RESULT_METAS) == 0) {
-        handleGetResultMetas(invocation, parameters);
+    if (trace_recorder) {
+        trace_recorder->record(method_name, parameters);
     }
-    else if (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_ACTIVATE_RESULT) == 0) {
-        handleActivateResult(invocation, parameters);
+    
+    if (!command_manager && g_strcmp0(method_name, PrimeCuts::Constants::METHOD_ACTIVATE_RESULT) == 0) {
+        LOG_DEBUG("Search index not ready yet, deferring activation");
+        pending_activations.push_back(static_cast<GDBusMethodInvocation*>(g_object_ref(invocation)));
+        return;
     }
-    else {
-        LOG_DEBUG("Unknown method called: " + std::string(method_name));
-        g_dbus_method_invocation_return_value(invocation, nullptr);
+    
+    if (search_coalescer && (g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_INITIAL_RESULT_SET) == 0 ||
+                             g_strcmp0(method_name, PrimeCuts::Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0)) {
+        search_coalescer->submit(sender, method_name, invocation);
+        return;
     }
+    
+    g_dbus_method_invocation_return_value(invocation, dispatchMethod(method_name, parameters));
 }
 
 static GDBusNodeInfo* introspection_data = nullptr;
@@ -255,7 +697,7 @@ static void on_bus_acquired(GDBusConnection* connection, const gchar* name, gpoi
 }
 
 static void on_name_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data) {
-    LOG_DEBUG("Name acquired successfully: " + std::string(name));
+    LOG_DEBUG("Name acquired successfully after " + std::to_string(millisecondsSinceStartup()) + " ms: " + std::string(name));
     LOG_INFO("GNOME Shell search provider registered successfully!");
 }
 
@@ -269,21 +711,85 @@ static void on_name_lost(GDBusConnection* connection, const gchar* name, gpointe
     }
 }
 
+
+// Feeds a recorded trace through dispatchMethod without D-Bus. Activations are
+// counted but not executed, so replaying never launches commands.
+int runReplay(const std::string& trace_path, const std::string& config_path, bool original_speed) {
+    PrimeCuts::TraceReader reader;
+    if (!reader.open(trace_path)) {
+        return 1;
+    }
+    if (reader.isAnonymized()) {
+        LOG_WARNING("Trace is anonymized, search terms will not match real actions");
+    }
+
+    PrimeCuts::ConfigLoader loader;
+    PrimeCuts::Config config;
+    if (!loader.loadConfig(config_path, config)) {
+        LOG_ERROR("Failed to load configuration");
+        return 1;
+    }
+    command_manager = std::make_unique<PrimeCuts::CommandManager>(config);
+
+    PrimeCuts::LatencyReport report;
+    size_t replayed = 0;
+    size_t skipped_activations = 0;
+    PrimeCuts::TraceRecord record;
+    while (reader.next(record)) {
+        if (original_speed && record.delay_us > 0) {
+            g_usleep(record.delay_us);
+        }
+
+        if (record.method == PrimeCuts::TraceMethod::ACTIVATE_RESULT) {
+            skipped_activations++;
+        } else {
+            gint64 start = g_get_monotonic_time();
+            GVariant* reply = dispatchMethod(PrimeCuts::traceMethodName(record.method), record.parameters);
+            gint64 end = g_get_monotonic_time();
+            report.add(PrimeCuts::traceMethodName(record.method), static_cast<double>(end - start));
+            if (reply) {
+                g_variant_unref(g_variant_ref_sink(reply));
+            }
+            replayed++;
+        }
+        g_variant_unref(record.parameters);
+        record.parameters = nullptr;
+    }
+
+    std::cout << "Replayed " << replayed << " calls from " << trace_path
+              << " (" << skipped_activations << " activations skipped)" << std::endl;
+    report.print();
+    return 0;
+}
+
 } // anonymous namespace
 
 int main(int argc, char* argv[]) {
     // Parse command line arguments
-    bool debug_mode = parseCommandLineArgs(argc, argv);
-    
-    LOG_DEBUG("Starting PrimeCuts DBus service...");
+    CommandLineOptions options = parseCommandLineArgs(argc, argv);
+    bool debug_mode = options.debug_mode;
     
-    // Initialize configuration before starting DBus service
-    if (!initializeConfiguration()) {
-        LOG_ERROR("Failed to initialize configuration. Exiting.");
-        return 1;
+    if (options.benchmark_actions > 0) {
+        return PrimeCuts::runShardBenchmark(options.benchmark_actions);
+    }
+    if (!options.headless.query.empty() || !options.headless.batch_file.empty()) {
+        return PrimeCuts::runHeadless(options.headless);
+    }
+    if (!options.replay_trace.empty()) {
+        return runReplay(options.replay_trace, options.headless.config_path, options.replay_original_speed);
+    }
+    if (!options.record_trace.empty()) {
+        trace_recorder = std::make_unique<PrimeCuts::TraceRecorder>();
+        if (!trace_recorder->open(options.record_trace, options.anonymize_trace)) {
+            return 1;
+        }
     }
     
-    GMainLoop* loop = g_main_loop_new(NULL, FALSE);
+    startup_time = g_get_monotonic_time();
+    last_call_time = startup_time;
+    LOG_DEBUG("Starting PrimeCuts DBus service...");
+    
+    main_loop = g_main_loop_new(NULL, FALSE);
     introspection_data = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
     
     if (!introspection_data) {
@@ -302,17 +808,37 @@ int main(int argc, char* argv[]) {
         on_name_lost,
         NULL, NULL);
 
+    g_unix_signal_add(SIGTERM, onQuitSignal, nullptr);
+    g_unix_signal_add(SIGINT, onQuitSignal, nullptr);
+    
+    // Parse the config and build the search index while the name is being acquired
+    GTask* load_task = g_task_new(nullptr, nullptr, onConfigurationLoaded, nullptr);
+    g_task_run_in_thread(load_task, loadConfigurationThread);
+    g_object_unref(load_task);
+
     if (debug_mode) {
         LOG_INFO("PrimeCuts DBus service running in debug mode...");
-        LOG_INFO("Configuration loaded with " + std::to_string(app_config.groups.size()) + " action groups.");
     } else {
         LOG_INFO("PrimeCuts DBus service running...");
     }
     
-    g_main_loop_run(loop);
+    g_main_loop_run(main_loop);
 
+    writeWarmSnapshot(false);
+    if (snapshot_timer) {
+        g_source_remove(snapshot_timer);
+    }
+    if (idle_timer) {
+        g_source_remove(idle_timer);
+    }
+    search_coalescer.reset();
+    source_manager.reset();
+    if (fragment_monitor) {
+        g_file_monitor_cancel(fragment_monitor);
+        g_object_unref(fragment_monitor);
+    }
     g_bus_unown_name(owner_id);
-    g_main_loop_unref(loop);
+    g_main_loop_unref(main_loop);
     g_dbus_node_info_unref(introspection_data);
-    return 0;
+    return startup_failed ? 1 : 0;
 }
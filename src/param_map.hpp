@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Small string map kept as one vector sorted by key. Most actions have no extra
+// parameters, and an empty ParamMap is an empty vector: no tree header, no allocation.
+class ParamMap {
+public:
+    using Entry = std::pair<std::string, std::string>;
+
+    const std::string* find(std::string_view key) const {
+        auto it = lowerBound(key);
+        return it != entries_.end() && it->first == key ? &it->second : nullptr;
+    }
+
+    void set(std::string_view key, std::string_view value) {
+        auto it = lowerBound(key);
+        if (it != entries_.end() && it->first == key) {
+            entries_[it - entries_.begin()].second = value;
+        } else {
+            entries_.emplace(entries_.begin() + (it - entries_.begin()), key, value);
+        }
+    }
+
+    // Entries whose key starts with prefix, e.g. "env." for all environment overrides
+    template <typename Function>
+    void forEachWithPrefix(std::string_view prefix, Function function) const {
+        for (auto it = lowerBound(prefix); it != entries_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            function(std::string_view(it->first).substr(prefix.size()), it->second);
+        }
+    }
+
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    std::vector<Entry>::const_iterator begin() const { return entries_.begin(); }
+    std::vector<Entry>::const_iterator end() const { return entries_.end(); }
+
+private:
+    std::vector<Entry> entries_;
+
+    std::vector<Entry>::const_iterator lowerBound(std::string_view key) const {
+        return std::lower_bound(entries_.begin(), entries_.end(), key,
+                                [](const Entry& entry, std::string_view value) { return entry.first < value; });
+    }
+};
+
+} // namespace PrimeCuts
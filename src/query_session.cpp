@@ -0,0 +1,55 @@
+#include "query_session.hpp"
+#include "constants.hpp"
+#include <charconv>
+
+namespace PrimeCuts {
+
+QuerySession& QuerySessionSlab::acquire(std::unique_lock<std::mutex>& lock) {
+    lock = std::unique_lock<std::mutex>(mutex_);
+    uint32_t id = next_id_++;
+    if (next_id_ == 0) {
+        next_id_ = 1;
+    }
+
+    QuerySession& session = slots_[id % SLOT_COUNT];
+    session.id = id;
+    return session;
+}
+
+uint32_t QuerySessionSlab::nextId() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_id_;
+}
+
+void QuerySessionSlab::resumeAt(uint32_t next_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (next_id > next_id_) {
+        next_id_ = next_id;
+    }
+}
+
+void QuerySessionSlab::encodeId(const char* base, uint32_t session_id, std::pmr::string& out) {
+    char digits[16];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), session_id);
+    out += base;
+    out += Constants::SESSION_ID_SEPARATOR;
+    out.append(digits, end);
+}
+
+std::string_view QuerySessionSlab::decodeId(std::string_view id, uint32_t& session_id) {
+    session_id = 0;
+    size_t pos = id.rfind(Constants::SESSION_ID_SEPARATOR);
+    if (pos == std::string_view::npos) {
+        return id;
+    }
+    for (size_t i = pos + 1; i < id.size(); ++i) {
+        if (id[i] < '0' || id[i] > '9') {
+            session_id = 0;
+            return id;
+        }
+        session_id = session_id * 10 + static_cast<uint32_t>(id[i] - '0');
+    }
+    return id.substr(0, pos);
+}
+
+} // namespace PrimeCuts
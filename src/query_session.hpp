@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace PrimeCuts {
+
+// Everything a later GetResultMetas or ActivateResult needs to know about one search
+struct QuerySession {
+    uint32_t id = 0; // 0 = slot never used
+    std::string encoded_query; // URL-encoded query; the virtual actions are built from it on demand
+};
+
+// Fixed number of sessions reused round-robin. Session ids grow monotonically and
+// id % slot count is the slot, so a stale id is detected by comparing it with the
+// id stored in its slot. A session stays valid until SLOT_COUNT newer searches ran.
+class QuerySessionSlab {
+public:
+    static constexpr size_t SLOT_COUNT = 64;
+
+    QuerySessionSlab() = default;
+    ~QuerySessionSlab() = default;
+
+    // Delete copy constructor and assignment operator
+    QuerySessionSlab(const QuerySessionSlab&) = delete;
+    QuerySessionSlab& operator=(const QuerySessionSlab&) = delete;
+
+    // Claims the oldest slot; the caller fills it while holding the returned lock
+    QuerySession& acquire(std::unique_lock<std::mutex>& lock);
+    // Calls read(session) while holding the lock, so a concurrent acquire() cannot reuse
+    // the slot meanwhile; read must copy what it needs. False if the session expired.
+    template <typename Read>
+    bool read(uint32_t id, Read&& read) const {
+        if (id == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        const QuerySession& session = slots_[id % SLOT_COUNT];
+        if (session.id != id) {
+            return false;
+        }
+        read(session);
+        return true;
+    }
+    // Session ids continue after a restart, so ids handed out before it never match a new session
+    uint32_t nextId() const;
+    void resumeAt(uint32_t next_id);
+
+    // Appends "<base>#<session>" for virtual result ids
+    static void encodeId(const char* base, uint32_t session_id, std::pmr::string& out);
+    // Splits an id produced by encodeId; session_id is 0 for ids without a session
+    static std::string_view decodeId(std::string_view id, uint32_t& session_id);
+
+private:
+    mutable std::mutex mutex_;
+    std::array<QuerySession, SLOT_COUNT> slots_;
+    uint32_t next_id_ = 1;
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,15 @@
+#include "request_arena.hpp"
+
+namespace PrimeCuts {
+
+RequestArena::RequestArena()
+    : buffer_(new std::byte[INITIAL_BYTES])
+    , resource_(buffer_.get(), INITIAL_BYTES) {
+}
+
+RequestArena& RequestArena::forThread() {
+    thread_local RequestArena arena;
+    return arena;
+}
+
+} // namespace PrimeCuts
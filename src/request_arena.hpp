@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace PrimeCuts {
+
+// Bump allocator for the short-lived containers of one D-Bus request. Nothing is
+// freed individually; reset() drops everything at once and rewinds to a buffer that
+// is reused by the next request, so a typical request never reaches malloc.
+// Each thread has its own arena, an arena must not be shared between threads.
+class RequestArena {
+public:
+    static constexpr size_t INITIAL_BYTES = 64 * 1024;
+
+    RequestArena();
+    ~RequestArena() = default;
+
+    // Delete copy constructor and assignment operator
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+    void reset() { resource_.release(); }
+
+    static RequestArena& forThread();
+
+    // Resets the calling thread's arena when the request is done
+    class Scope {
+    public:
+        Scope() = default;
+        ~Scope() { RequestArena::forThread().reset(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+} // namespace PrimeCuts
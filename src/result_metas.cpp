@@ -0,0 +1,82 @@
+#include "result_metas.hpp"
+#include "constants.hpp"
+#include "logger.hpp"
+#include <string>
+
+namespace PrimeCuts {
+
+namespace {
+
+const Action* findConfigAction(const Config& config, std::string_view id) {
+    for (const auto& group : config.groups) {
+        for (const auto& action : group.actions) {
+            if (action.id == id) {
+                return &action;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void addResultMeta(GVariantBuilder* outer, const char* id, const char* name, const char* description,
+                   GVariant* icon, const char* clipboard_text) {
+    GVariantBuilder meta;
+    g_variant_builder_init(&meta, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&meta, "{sv}", "id", g_variant_new_string(id));
+    g_variant_builder_add(&meta, "{sv}", "name", g_variant_new_string(name));
+    g_variant_builder_add(&meta, "{sv}", "description", g_variant_new_string(description));
+    g_variant_builder_add(&meta, "{sv}", "icon", icon);
+    if (clipboard_text) {
+        g_variant_builder_add(&meta, "{sv}", "clipboardText", g_variant_new_string(clipboard_text));
+    }
+    g_variant_builder_add(outer, "a{sv}", &meta);
+}
+
+} // anonymous namespace
+
+GVariant* buildResultMetas(GVariant* parameters, const MetaSources& sources) {
+    GVariantIter iter;
+    g_variant_iter_init(&iter, parameters);
+    GVariant* ids_array = g_variant_iter_next_value(&iter);
+
+    GVariantBuilder outer;
+    g_variant_builder_init(&outer, G_VARIANT_TYPE("aa{sv}"));
+
+    Action virtual_action; // Copy of a virtual action, whose session slot may be reused
+    if (ids_array) {
+        GVariantIter ids_iter;
+        g_variant_iter_init(&ids_iter, ids_array);
+
+        const gchar* id;
+        while (g_variant_iter_next(&ids_iter, "&s", &id)) {
+            LOG_DEBUG("Getting meta for ID: " + std::string(id));
+            const Action* action = nullptr;
+            if (sources.manager) {
+                action = sources.manager->resolveAction(id, virtual_action);
+            } else if (CommandManager::sessionlessAction(id, virtual_action)) {
+                action = &virtual_action;
+            } else if (sources.loading_config) {
+                action = findConfigAction(*sources.loading_config, id);
+            }
+            if (action) {
+                // The loader thread may still be filling the cache while the parsed config answers
+                GVariant* icon = sources.manager && sources.icons ? sources.icons->lookup(action->icon) : nullptr;
+                const std::string* clipboard_text = action->extra_params.find(Constants::PARAM_CLIPBOARD_TEXT);
+                addResultMeta(&outer, id, action->name.c_str(), action->description.c_str(),
+                              icon ? icon : g_variant_new_string(action->icon.c_str()),
+                              clipboard_text ? clipboard_text->c_str() : nullptr);
+            } else if (const SnapshotAction* warm = sources.snapshot ? sources.snapshot->findAction(id) : nullptr) {
+                // A result of the warm snapshot whose group is not parsed yet, e.g. a generated action
+                addResultMeta(&outer, id, warm->name.data(), warm->description.data(), g_variant_new_string(warm->icon.data()),
+                              warm->clipboard_text.empty() ? nullptr : warm->clipboard_text.data());
+            } else {
+                LOG_DEBUG("No action found for ID: " + std::string(id));
+            }
+        }
+        g_variant_unref(ids_array);
+    }
+
+    return g_variant_new("(aa{sv})", &outer);
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "command_manager.hpp"
+#include "config.hpp"
+#include "icon_cache.hpp"
+#include "warm_snapshot.hpp"
+#include <gio/gio.h>
+
+namespace PrimeCuts {
+
+// Where GetResultMetas finds the action of an id. The index answers once it is ready;
+// during startup the parsed config and the warm snapshot do.
+struct MetaSources {
+    const CommandManager* manager = nullptr;
+    IconCache* icons = nullptr;             // Serialized icons, only used with manager
+    const Config* loading_config = nullptr;
+    const WarmSnapshot* snapshot = nullptr;
+};
+
+// Reply "(aa{sv})" of GetResultMetas for its parameters "(as)"; ids without an action
+// are left out. Shared by the D-Bus handlers and the headless batch mode.
+GVariant* buildResultMetas(GVariant* parameters, const MetaSources& sources);
+
+} // namespace PrimeCuts
@@ -0,0 +1,164 @@
+#include "search_coalescer.hpp"
+#include "constants.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+namespace PrimeCuts {
+
+SearchCoalescer::SearchCoalescer(guint window_ms, Handler handler)
+    : window_ms_(window_ms)
+    , handler_(std::move(handler)) {
+}
+
+SearchCoalescer::~SearchCoalescer() {
+    if (prune_timer_id_ > 0) {
+        g_source_remove(prune_timer_id_);
+    }
+    flushAll();
+    if (coalesced_count_ > 0) {
+        LOG_DEBUG("Coalesced " + std::to_string(coalesced_count_) + " search calls");
+    }
+}
+
+void SearchCoalescer::submit(const gchar* sender, const gchar* method_name, GDBusMethodInvocation* invocation) {
+    gint64 now = g_get_monotonic_time();
+
+    auto& slot = bursts_[sender ? sender : ""];
+    if (!slot) {
+        slot = std::make_unique<Burst>();
+        slot->owner = this;
+        if (prune_timer_id_ == 0) {
+            prune_timer_id_ = g_timeout_add_seconds(PRUNE_INTERVAL_SECONDS, onPruneTimer, this);
+        }
+    }
+    Burst& burst = *slot;
+
+    std::string query = queryOf(method_name, g_dbus_method_invocation_get_parameters(invocation));
+    if (!burst.invocations.empty()) {
+        if (isRefinement(burst.query, query)) {
+            hold(burst, invocation, std::move(query));
+            return;
+        }
+        // A different query: the held ones are answered on their own
+        answer(burst);
+    }
+
+    gint64 elapsed_ms = (now - burst.last_answer_time) / 1000;
+    if (burst.last_answer_time == 0 || elapsed_ms >= window_ms_) {
+        burst.last_answer_time = now;
+        g_dbus_method_invocation_return_value(invocation, handler_(method_name, g_dbus_method_invocation_get_parameters(invocation)));
+        return;
+    }
+
+    hold(burst, invocation, std::move(query));
+    guint delay = static_cast<guint>(std::max<gint64>(window_ms_ - elapsed_ms, 1));
+    burst.timer_id = g_timeout_add(delay, onWindowEnd, &burst);
+}
+
+void SearchCoalescer::hold(Burst& burst, GDBusMethodInvocation* invocation, std::string query) {
+    burst.invocations.push_back(static_cast<GDBusMethodInvocation*>(g_object_ref(invocation)));
+    burst.query = std::move(query);
+    // Idle sources only run once the calls already queued are dispatched, so a held call
+    // waits for the calls that supersede it, not for the rest of the window
+    if (burst.idle_id == 0) {
+        burst.idle_id = g_idle_add(onIdle, &burst);
+    }
+}
+
+// A sender whose window has closed is answered at once anyway, its entry can go
+void SearchCoalescer::pruneClosedWindows(gint64 now) {
+    for (auto it = bursts_.begin(); it != bursts_.end();) {
+        const Burst& burst = *it->second;
+        bool closed = burst.invocations.empty() && (now - burst.last_answer_time) / 1000 >= window_ms_;
+        it = closed ? bursts_.erase(it) : std::next(it);
+    }
+}
+
+void SearchCoalescer::flushAll() {
+    for (auto& [sender, burst] : bursts_) {
+        if (!burst->invocations.empty()) {
+            answer(*burst);
+        }
+    }
+}
+
+void SearchCoalescer::answer(Burst& burst) {
+    if (burst.timer_id > 0) {
+        g_source_remove(burst.timer_id);
+        burst.timer_id = 0;
+    }
+    if (burst.idle_id > 0) {
+        g_source_remove(burst.idle_id);
+        burst.idle_id = 0;
+    }
+
+    // Only the newest call is computed. The results of a shorter query are broader, so the
+    // older calls get an empty list rather than the newest results; the shell drops them anyway.
+    GDBusMethodInvocation* newest = burst.invocations.back();
+    if (burst.invocations.size() > 1) {
+        GVariant* empty = g_variant_ref_sink(g_variant_new("(@as)", g_variant_new_strv(nullptr, 0)));
+        for (size_t i = 0; i + 1 < burst.invocations.size(); ++i) {
+            g_dbus_method_invocation_return_value(burst.invocations[i], empty);
+            g_object_unref(burst.invocations[i]);
+        }
+        g_variant_unref(empty);
+    }
+    g_dbus_method_invocation_return_value(newest, handler_(g_dbus_method_invocation_get_method_name(newest),
+                                                           g_dbus_method_invocation_get_parameters(newest)));
+    g_object_unref(newest);
+
+    coalesced_count_ += burst.invocations.size() - 1;
+    LOG_DEBUG("Answered " + std::to_string(burst.invocations.size()) + " held searches with '" + burst.query + "'");
+    burst.invocations.clear();
+    burst.last_answer_time = g_get_monotonic_time();
+}
+
+std::string SearchCoalescer::queryOf(const gchar* method_name, GVariant* parameters) {
+    // The terms are the last argument of both search methods
+    bool subsearch = g_strcmp0(method_name, Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0;
+    GVariant* terms = g_variant_get_child_value(parameters, subsearch ? 1 : 0);
+
+    std::string query;
+    gsize count = 0;
+    const gchar** strings = g_variant_get_strv(terms, &count);
+    for (gsize i = 0; i < count; ++i) {
+        if (i > 0) query += ' ';
+        query += strings[i];
+    }
+    g_free(strings);
+    g_variant_unref(terms);
+    return query;
+}
+
+bool SearchCoalescer::isRefinement(const std::string& previous, const std::string& query) {
+    // Typing extends the query, backspace shortens it
+    const std::string& shorter = previous.size() <= query.size() ? previous : query;
+    const std::string& longer = previous.size() <= query.size() ? query : previous;
+    return longer.compare(0, shorter.size(), shorter) == 0;
+}
+
+gboolean SearchCoalescer::onWindowEnd(gpointer user_data) {
+    auto* burst = static_cast<Burst*>(user_data);
+    burst->timer_id = 0; // Removed by returning G_SOURCE_REMOVE
+    burst->owner->answer(*burst);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean SearchCoalescer::onPruneTimer(gpointer user_data) {
+    auto* coalescer = static_cast<SearchCoalescer*>(user_data);
+    coalescer->pruneClosedWindows(g_get_monotonic_time());
+    if (coalescer->bursts_.empty()) {
+        coalescer->prune_timer_id_ = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean SearchCoalescer::onIdle(gpointer user_data) {
+    auto* burst = static_cast<Burst*>(user_data);
+    burst->idle_id = 0; // Removed by returning G_SOURCE_REMOVE
+    burst->owner->answer(*burst);
+    return G_SOURCE_REMOVE;
+}
+
+} // namespace PrimeCuts
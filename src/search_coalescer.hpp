@@ -0,0 +1,64 @@
+#pragma once
+
+#include <gio/gio.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Debounces the GetInitialResultSet/GetSubsearchResultSet bursts of fast typing.
+// A sender's first search in a window is answered right away. Searches arriving
+// before the window ends are held; while each one extends or shortens the previous
+// query, only the newest is computed; it gets the results and the older held calls,
+// which the shell no longer shows, get an empty list. Held calls are answered once
+// the main loop has no newer call queued, and at the latest when the window ends.
+class SearchCoalescer {
+public:
+    // Computes the reply of one search call
+    using Handler = std::function<GVariant*(const gchar* method_name, GVariant* parameters)>;
+
+    SearchCoalescer(guint window_ms, Handler handler);
+    ~SearchCoalescer();
+
+    // Delete copy constructor and assignment operator
+    SearchCoalescer(const SearchCoalescer&) = delete;
+    SearchCoalescer& operator=(const SearchCoalescer&) = delete;
+
+    // Answers invocation now or later; takes its own reference when holding it
+    void submit(const gchar* sender, const gchar* method_name, GDBusMethodInvocation* invocation);
+    // Answers every held call
+    void flushAll();
+
+private:
+    // Senders whose window closed are forgotten this often while any are known
+    static constexpr guint PRUNE_INTERVAL_SECONDS = 30;
+
+    struct Burst {
+        SearchCoalescer* owner = nullptr;
+        std::string query; // Joined terms of the newest held call
+        std::vector<GDBusMethodInvocation*> invocations; // Oldest first
+        gint64 last_answer_time = 0;
+        guint timer_id = 0; // Window end
+        guint idle_id = 0;  // Main loop idle: nothing newer is queued
+    };
+
+    guint window_ms_;
+    Handler handler_;
+    std::unordered_map<std::string, std::unique_ptr<Burst>> bursts_; // By D-Bus sender
+    size_t coalesced_count_ = 0;
+    guint prune_timer_id_ = 0;
+
+    void hold(Burst& burst, GDBusMethodInvocation* invocation, std::string query);
+    void answer(Burst& burst);
+    void pruneClosedWindows(gint64 now);
+    static std::string queryOf(const gchar* method_name, GVariant* parameters);
+    static bool isRefinement(const std::string& previous, const std::string& query);
+    static gboolean onWindowEnd(gpointer user_data);
+    static gboolean onIdle(gpointer user_data);
+    static gboolean onPruneTimer(gpointer user_data);
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,740 @@
+#include "search_index.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <string_view>
+
+namespace PrimeCuts {
+
+namespace {
+
+// Per-term scores, a term only counts with the best field it matches
+const uint32_t SCORE_NAME_WORD_PREFIX = 90;
+const uint32_t SCORE_KEYWORD_PREFIX = 80;
+const uint32_t SCORE_NAME_SUBSTRING = 60;
+const uint32_t SCORE_KEYWORD_SUBSTRING = 50;
+const uint32_t SCORE_DESCRIPTION = 20;
+const uint32_t SCORE_ID = 10;
+
+// In ranked mode every matched term outweighs any sum of per-term scores
+const uint32_t SCORE_PER_MATCHED_TERM = 1000;
+
+// Score of every action of an activated group when the query is only the prefix
+const uint32_t SCORE_ACTIVATED = 1;
+
+// Entries scored between two looks at the clock
+const uint32_t DEADLINE_CHECK_INTERVAL = 256;
+
+// Longest single term answered from the precomputed prefix lists
+const size_t SHORT_QUERY_LENGTH = 2;
+
+struct PrefixPosting {
+    uint32_t key;
+    uint32_t entry;
+    uint32_t score;
+};
+
+bool isWordStart(std::string_view text, size_t pos) {
+    return pos == 0 || !std::isalnum(static_cast<unsigned char>(text[pos - 1]));
+}
+
+uint32_t scoreField(std::string_view field, std::string_view term, uint32_t prefix_score, uint32_t substring_score) {
+    size_t pos = field.find(term);
+    if (pos == std::string_view::npos) {
+        return 0;
+    }
+    for (; pos != std::string_view::npos; pos = field.find(term, pos + 1)) {
+        if (isWordStart(field, pos)) {
+            return prefix_score;
+        }
+    }
+    return substring_score;
+}
+
+// Length in the high bits, so "a" and "a\0" differ
+uint32_t prefixKey(std::string_view prefix) {
+    uint32_t key = static_cast<uint32_t>(prefix.size()) << 16;
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        key |= static_cast<uint32_t>(static_cast<unsigned char>(prefix[i])) << (8 * (1 - i));
+    }
+    return key;
+}
+
+// Keys of the one- and two-character prefixes starting at every word start of a field
+void collectPrefixKeys(std::string_view field, std::vector<uint32_t>& keys) {
+    for (size_t pos = 0; pos < field.size(); ++pos) {
+        if (!isWordStart(field, pos)) {
+            continue;
+        }
+        for (size_t length = 1; length <= SHORT_QUERY_LENGTH && pos + length <= field.size(); ++length) {
+            keys.push_back(prefixKey(field.substr(pos, length)));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+size_t pairBit(unsigned char first, unsigned char second) {
+    return (first * 131u + second) & 4095u;
+}
+
+bool rankBefore(const SearchHit& a, const SearchHit& b) {
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    return a.ordinal < b.ordinal;
+}
+
+} // anonymous namespace
+
+std::string SearchIndex::fold(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+SearchIndex::Deadline::Deadline(std::chrono::microseconds budget)
+    : enabled_(budget.count() > 0)
+    , at_(std::chrono::steady_clock::now() + budget) {
+}
+
+bool SearchIndex::Deadline::expired() const {
+    if (!enabled_) {
+        return false;
+    }
+    if (expired_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (std::chrono::steady_clock::now() < at_) {
+        return false;
+    }
+    expired_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool SearchIndex::parseMatchMode(const std::string& value, MatchMode& mode) {
+    if (value == "any") {
+        mode = MatchMode::ANY;
+    } else if (value == "all") {
+        mode = MatchMode::ALL;
+    } else if (value == "ranked") {
+        mode = MatchMode::RANKED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SearchHits SearchIndex::scan(const Config& config, const std::vector<std::string>& folded_terms, size_t max_results,
+                             MatchMode mode) {
+    SearchHits hits;
+    if (folded_terms.empty()) {
+        return hits;
+    }
+
+    bool activated = std::any_of(config.groups.begin(), config.groups.end(),
+                                 [&](const Group& group) { return !group.prefix.empty() && fold(group.prefix) == folded_terms[0]; });
+    std::vector<std::string> remaining_terms;
+    if (activated) {
+        remaining_terms.assign(folded_terms.begin() + 1, folded_terms.end());
+    }
+
+    Segment segment;
+    uint32_t base = 0;
+    for (const auto& group : config.groups) {
+        if (!activated || fold(group.prefix) == folded_terms[0]) {
+            buildSegment(group, segment);
+            segment.base = base;
+            if (activated) {
+                searchActivated(segment, remaining_terms, mode, Deadline(), hits);
+            } else if (mayMatch(segment, folded_terms, mode)) {
+                searchSlice(segment, 0, static_cast<uint32_t>(segment.entries.size()), folded_terms, mode, Deadline(), hits);
+            }
+        }
+        base += static_cast<uint32_t>(group.actions.size());
+    }
+    selectTop(hits, max_results);
+    return hits;
+}
+
+void SearchIndex::build(const Config& config) {
+    segments_.clear();
+    segments_.resize(config.groups.size());
+    std::vector<size_t> group_indexes(config.groups.size());
+    for (size_t g = 0; g < group_indexes.size(); ++g) {
+        group_indexes[g] = g;
+    }
+    indexGroups(config, group_indexes);
+    updateOrdinals();
+    assignShards();
+}
+
+// Segments are independent, the search workers index them in parallel
+void SearchIndex::indexGroups(const Config& config, const std::vector<size_t>& group_indexes) {
+    auto build_segment = [&](size_t i) {
+        size_t g = group_indexes[i];
+        buildSegment(config.groups[g], segments_[g]);
+        indexSegment(segments_[g]);
+    };
+    if (pool_ && group_indexes.size() > 1) {
+        pool_->run(group_indexes.size(), build_segment);
+    } else {
+        for (size_t i = 0; i < group_indexes.size(); ++i) {
+            build_segment(i);
+        }
+    }
+}
+
+void SearchIndex::GroupFilter::build(std::string_view text) {
+    bytes.fill(0);
+    pairs.fill(0);
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        bytes[c / 64] |= uint64_t(1) << (c % 64);
+        if (i + 1 < text.size()) {
+            size_t bit = pairBit(c, static_cast<unsigned char>(text[i + 1]));
+            pairs[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+}
+
+bool SearchIndex::GroupFilter::mayContain(std::string_view term) const {
+    if (term.size() == 1) {
+        unsigned char c = static_cast<unsigned char>(term[0]);
+        return (bytes[c / 64] >> (c % 64)) & 1;
+    }
+    for (size_t i = 0; i + 1 < term.size(); ++i) {
+        size_t bit = pairBit(static_cast<unsigned char>(term[i]), static_cast<unsigned char>(term[i + 1]));
+        if (((pairs[bit / 64] >> (bit % 64)) & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SearchIndex::rebuildGroup(size_t group_index, const Group& group) {
+    if (group_index >= segments_.size()) {
+        segments_.resize(group_index + 1);
+    }
+    buildSegment(group, segments_[group_index]);
+    indexSegment(segments_[group_index]);
+    updateOrdinals();
+    assignShards();
+}
+
+void SearchIndex::updateGroups(const Config& config, const std::vector<bool>& removed, std::vector<size_t> changed_groups) {
+    size_t kept = 0;
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        if (s >= removed.size() || !removed[s]) {
+            if (kept != s) {
+                segments_[kept] = std::move(segments_[s]);
+            }
+            kept++;
+        }
+    }
+    segments_.resize(kept);
+    segments_.resize(config.groups.size());
+
+    std::sort(changed_groups.begin(), changed_groups.end());
+    changed_groups.erase(std::unique(changed_groups.begin(), changed_groups.end()), changed_groups.end());
+    indexGroups(config, changed_groups);
+    updateOrdinals();
+    assignShards();
+}
+
+void SearchIndex::setShardCount(size_t shard_count) {
+    shard_count_ = std::max<size_t>(shard_count, 1);
+    pool_.reset();
+    if (shard_count_ > 1) {
+        pool_ = std::make_unique<WorkerPool>(shard_count_ - 1);
+    }
+    assignShards();
+}
+
+void SearchIndex::buildSegment(const Group& group, Segment& segment) {
+    segment.text.clear();
+    segment.entries.clear();
+    segment.entries.reserve(group.actions.size());
+
+    auto append = [&segment](const std::string& value) {
+        Field field;
+        field.offset = static_cast<uint32_t>(segment.text.size());
+        field.length = static_cast<uint32_t>(value.size());
+        segment.text += value;
+        return field;
+    };
+
+    for (const auto& action : group.actions) {
+        Entry entry;
+        entry.action = &action;
+        entry.name = append(action.name);
+
+        entry.keywords.offset = static_cast<uint32_t>(segment.text.size());
+        for (size_t k = 0; k < action.keywords.size(); ++k) {
+            if (k > 0) segment.text += KEYWORD_SEPARATOR;
+            segment.text += action.keywords[k];
+        }
+        entry.keywords.length = static_cast<uint32_t>(segment.text.size() - entry.keywords.offset);
+
+        entry.description = append(action.description);
+        entry.id = append(action.id);
+        segment.entries.push_back(entry);
+    }
+
+    std::transform(segment.text.begin(), segment.text.end(), segment.text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    segment.prefix = fold(group.prefix);
+    segment.filter.build(segment.text);
+}
+
+void SearchIndex::updateOrdinals() {
+    uint32_t base = 0;
+    has_activation_prefixes_ = false;
+    for (auto& segment : segments_) {
+        segment.base = base;
+        base += static_cast<uint32_t>(segment.entries.size());
+        has_activation_prefixes_ = has_activation_prefixes_ || !segment.prefix.empty();
+    }
+    total_entries_ = base;
+}
+
+void SearchIndex::assignShards() {
+    shards_.assign(shard_count_, Shard());
+
+    // Equal-sized contiguous ordinal ranges, cut across group boundaries where needed
+    size_t per_shard = (total_entries_ + shard_count_ - 1) / shard_count_;
+    size_t shard = 0;
+    size_t filled = 0;
+    for (uint32_t s = 0; s < segments_.size(); ++s) {
+        uint32_t begin = 0;
+        uint32_t size = static_cast<uint32_t>(segments_[s].entries.size());
+        while (begin < size) {
+            uint32_t take = static_cast<uint32_t>(std::min<size_t>(size - begin, per_shard - filled));
+            shards_[shard].slices.push_back({s, begin, begin + take});
+            begin += take;
+            filled += take;
+            if (filled == per_shard && shard + 1 < shard_count_) {
+                shard++;
+                filled = 0;
+            }
+        }
+    }
+}
+
+bool SearchIndex::isShortQuery(const std::vector<std::string>& folded_terms) {
+    return folded_terms.size() == 1 && folded_terms[0].size() <= SHORT_QUERY_LENGTH;
+}
+
+void SearchIndex::indexSegment(Segment& segment) {
+    buildPrefixLists(segment);
+    buildTrigrams(segment);
+}
+
+void SearchIndex::buildPrefixLists(Segment& segment) {
+    segment.prefix_lists.clear();
+    segment.prefix_entries.clear();
+
+    std::vector<PrefixPosting> postings;
+    std::vector<uint32_t> name_keys;
+    std::vector<uint32_t> keyword_keys;
+    std::string_view text(segment.text);
+    for (uint32_t i = 0; i < segment.entries.size(); ++i) {
+        const Entry& entry = segment.entries[i];
+        name_keys.clear();
+        keyword_keys.clear();
+        collectPrefixKeys(text.substr(entry.name.offset, entry.name.length), name_keys);
+        collectPrefixKeys(text.substr(entry.keywords.offset, entry.keywords.length), keyword_keys);
+
+        for (uint32_t key : name_keys) {
+            postings.push_back({key, i, SCORE_NAME_WORD_PREFIX});
+        }
+        for (uint32_t key : keyword_keys) {
+            if (!std::binary_search(name_keys.begin(), name_keys.end(), key)) {
+                postings.push_back({key, i, SCORE_KEYWORD_PREFIX});
+            }
+        }
+    }
+
+    // Same total order as rankBefore within every key
+    std::sort(postings.begin(), postings.end(), [](const PrefixPosting& a, const PrefixPosting& b) {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.score != b.score) return a.score > b.score;
+        return a.entry < b.entry;
+    });
+
+    segment.prefix_entries.reserve(postings.size());
+    for (size_t p = 0; p < postings.size(); ++p) {
+        if (p == 0 || postings[p].key != postings[p - 1].key) {
+            uint32_t begin = static_cast<uint32_t>(p);
+            segment.prefix_lists.push_back({postings[p].key, begin, begin, begin});
+        }
+        PrefixList& list = segment.prefix_lists.back();
+        if (postings[p].score == SCORE_NAME_WORD_PREFIX) {
+            list.name_end++;
+        }
+        list.end++;
+        segment.prefix_entries.push_back(postings[p].entry);
+    }
+}
+
+void SearchIndex::buildTrigrams(Segment& segment) {
+    segment.trigrams.clear();
+    std::vector<std::string_view> fields(4);
+    std::string_view text(segment.text);
+    for (uint32_t i = 0; i < segment.entries.size(); ++i) {
+        const Entry& entry = segment.entries[i];
+        fields[0] = text.substr(entry.name.offset, entry.name.length);
+        fields[1] = text.substr(entry.keywords.offset, entry.keywords.length);
+        fields[2] = text.substr(entry.description.offset, entry.description.length);
+        fields[3] = text.substr(entry.id.offset, entry.id.length);
+        segment.trigrams.add(i, fields);
+    }
+    segment.trigrams.finish(static_cast<uint32_t>(segment.entries.size()));
+}
+
+size_t SearchIndex::memoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& segment : segments_) {
+        bytes += sizeof(Segment) + segment.text.capacity() + segment.entries.capacity() * sizeof(Entry)
+            + segment.prefix_lists.capacity() * sizeof(PrefixList) + segment.prefix_entries.capacity() * sizeof(uint32_t)
+            + segment.trigrams.memoryUsage();
+    }
+    return bytes;
+}
+
+size_t SearchIndex::postingMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& segment : segments_) {
+        bytes += segment.trigrams.memoryUsage();
+    }
+    return bytes;
+}
+
+// Any mode needs candidates for every term; in all mode one term bounds the result
+bool SearchIndex::usesTrigrams(const std::vector<std::string>& folded_terms, MatchMode mode) {
+    auto indexed = [](const std::string& term) { return term.size() >= 3; };
+    if (mode == MatchMode::ALL) {
+        return std::any_of(folded_terms.begin(), folded_terms.end(), indexed);
+    }
+    return std::all_of(folded_terms.begin(), folded_terms.end(), indexed);
+}
+
+void SearchIndex::searchSliceTrigrams(const Segment& segment, uint32_t begin, uint32_t end,
+                                      const std::vector<std::string>& folded_terms, MatchMode mode,
+                                      const Deadline& deadline, SearchHits& hits) {
+    bool match_all = mode == MatchMode::ALL;
+    std::pmr::memory_resource* memory = hits.get_allocator().resource();
+    std::pmr::vector<TrigramIndex::TermQuery> queries(memory);
+    for (const auto& term : folded_terms) {
+        if (term.size() < 3) {
+            continue;
+        }
+        TrigramIndex::TermQuery query(memory);
+        if (segment.trigrams.prepare(term, query)) {
+            queries.push_back(std::move(query));
+        } else if (match_all) {
+            return; // A term that occurs nowhere in the group, nothing here can match all terms
+        }
+    }
+    if (queries.empty()) {
+        return;
+    }
+
+    std::pmr::vector<uint16_t> candidates(memory);
+    std::pmr::vector<uint16_t> term_candidates(memory);
+    std::pmr::vector<uint16_t> merged(memory);
+    size_t scored = 0;
+    uint32_t last_chunk = (end - 1) >> TrigramIndex::CHUNK_BITS;
+    for (uint32_t chunk = begin >> TrigramIndex::CHUNK_BITS; chunk <= last_chunk && !deadline.expired(); ++chunk) {
+        // Part of the slice inside this chunk, relative to the chunk
+        uint32_t chunk_base = chunk << TrigramIndex::CHUNK_BITS;
+        uint32_t chunk_begin = std::max(begin, chunk_base) - chunk_base;
+        uint32_t chunk_end = std::min<uint32_t>(end - chunk_base, uint32_t(1) << TrigramIndex::CHUNK_BITS);
+
+        for (size_t q = 0; q < queries.size(); ++q) {
+            std::pmr::vector<uint16_t>& target = q == 0 ? candidates : term_candidates;
+            bool found = segment.trigrams.intersectChunk(queries[q], chunk, chunk_begin, chunk_end, target);
+            if (q == 0) {
+                if (!found && match_all) break;
+                continue;
+            }
+            if (match_all) {
+                merged.clear();
+                std::set_intersection(candidates.begin(), candidates.end(), term_candidates.begin(),
+                                      term_candidates.end(), std::back_inserter(merged));
+                candidates.swap(merged);
+                if (candidates.empty()) break;
+            } else if (found) {
+                merged.clear();
+                std::set_union(candidates.begin(), candidates.end(), term_candidates.begin(),
+                               term_candidates.end(), std::back_inserter(merged));
+                candidates.swap(merged);
+            }
+        }
+
+        // Candidates only share trigrams with the terms; scoring decides
+        for (uint16_t offset : candidates) {
+            if (++scored % DEADLINE_CHECK_INTERVAL == 0 && deadline.expired()) {
+                return;
+            }
+            uint32_t index = chunk_base + offset;
+            const Entry& entry = segment.entries[index];
+            uint32_t score = scoreEntry(segment, entry, folded_terms, mode);
+            if (score > 0) {
+                hits.push_back({entry.action, segment.base + index, score});
+            }
+        }
+    }
+}
+
+void SearchIndex::searchPrefixList(const std::string& folded_term, size_t max_results, SearchHits& hits) const {
+    uint32_t key = prefixKey(folded_term);
+    std::pmr::vector<std::pair<const Segment*, const PrefixList*>> lists(hits.get_allocator().resource());
+    for (const auto& segment : segments_) {
+        if (!segment.filter.mayContain(folded_term)) {
+            continue;
+        }
+        auto it = std::lower_bound(segment.prefix_lists.begin(), segment.prefix_lists.end(), key,
+                                   [](const PrefixList& list, uint32_t value) { return list.key < value; });
+        if (it != segment.prefix_lists.end() && it->key == key) {
+            lists.emplace_back(&segment, &*it);
+        }
+    }
+
+    // Every list is ranked and segments are in ordinal order, so all name matches in
+    // segment order followed by all keyword matches is the merged ranking
+    for (uint32_t score : {SCORE_NAME_WORD_PREFIX, SCORE_KEYWORD_PREFIX}) {
+        for (const auto& [segment, list] : lists) {
+            uint32_t begin = score == SCORE_NAME_WORD_PREFIX ? list->begin : list->name_end;
+            uint32_t end = score == SCORE_NAME_WORD_PREFIX ? list->name_end : list->end;
+            for (uint32_t p = begin; p < end; ++p) {
+                if (max_results > 0 && hits.size() == max_results) {
+                    return;
+                }
+                uint32_t index = segment->prefix_entries[p];
+                hits.push_back({segment->entries[index].action, segment->base + index, score});
+            }
+        }
+    }
+}
+
+uint32_t SearchIndex::scoreTerm(const Segment& segment, const Entry& entry, std::string_view term) {
+    std::string_view text(segment.text);
+    std::string_view name = text.substr(entry.name.offset, entry.name.length);
+    uint32_t best = scoreField(name, term, SCORE_NAME_WORD_PREFIX, SCORE_NAME_SUBSTRING);
+    if (best < SCORE_NAME_WORD_PREFIX) {
+        std::string_view keywords = text.substr(entry.keywords.offset, entry.keywords.length);
+        best = std::max(best, scoreField(keywords, term, SCORE_KEYWORD_PREFIX, SCORE_KEYWORD_SUBSTRING));
+    }
+    if (best == 0 && text.substr(entry.description.offset, entry.description.length).find(term) != std::string_view::npos) {
+        best = SCORE_DESCRIPTION;
+    }
+    if (best == 0 && text.substr(entry.id.offset, entry.id.length).find(term) != std::string_view::npos) {
+        best = SCORE_ID;
+    }
+    return best;
+}
+
+uint32_t SearchIndex::scoreEntry(const Segment& segment, const Entry& entry, const std::vector<std::string>& folded_terms,
+                                 MatchMode mode) {
+    // Short single terms only count at word starts, like the prefix lists
+    if (isShortQuery(folded_terms)) {
+        std::string_view text(segment.text);
+        const std::string& term = folded_terms[0];
+        if (scoreField(text.substr(entry.name.offset, entry.name.length), term, SCORE_NAME_WORD_PREFIX, 0) == SCORE_NAME_WORD_PREFIX) {
+            return SCORE_NAME_WORD_PREFIX;
+        }
+        std::string_view keywords = text.substr(entry.keywords.offset, entry.keywords.length);
+        return scoreField(keywords, term, SCORE_KEYWORD_PREFIX, 0) == SCORE_KEYWORD_PREFIX ? SCORE_KEYWORD_PREFIX : 0;
+    }
+
+    uint32_t total = 0;
+    uint32_t matched = 0;
+    for (const auto& term : folded_terms) {
+        uint32_t best = scoreTerm(segment, entry, term);
+        if (best == 0 && mode == MatchMode::ALL) {
+            return 0;
+        }
+        total += best;
+        matched += best > 0 ? 1 : 0;
+    }
+    if (mode == MatchMode::RANKED && folded_terms.size() > 1 && matched > 0) {
+        total += matched * SCORE_PER_MATCHED_TERM;
+    }
+    return total;
+}
+
+void SearchIndex::searchSlice(const Segment& segment, uint32_t begin, uint32_t end, const std::vector<std::string>& folded_terms,
+                              MatchMode mode, const Deadline& deadline, SearchHits& hits) {
+    if (mode == MatchMode::ALL && folded_terms.size() > 1) {
+        searchSliceAll(segment, begin, end, folded_terms, deadline, hits);
+        return;
+    }
+    for (uint32_t i = begin; i < end; ++i) {
+        if ((i - begin) % DEADLINE_CHECK_INTERVAL == 0 && deadline.expired()) {
+            return;
+        }
+        const Entry& entry = segment.entries[i];
+        uint32_t score = scoreEntry(segment, entry, folded_terms, mode);
+        if (score > 0) {
+            hits.push_back({entry.action, segment.base + i, score});
+        }
+    }
+}
+
+bool SearchIndex::mayMatch(const Segment& segment, const std::vector<std::string>& folded_terms, MatchMode mode) {
+    auto may_contain = [&segment](const std::string& term) { return segment.filter.mayContain(term); };
+    if (mode == MatchMode::ALL) {
+        return std::all_of(folded_terms.begin(), folded_terms.end(), may_contain);
+    }
+    return std::any_of(folded_terms.begin(), folded_terms.end(), may_contain);
+}
+
+void SearchIndex::searchActivated(const Segment& segment, const std::vector<std::string>& remaining_terms,
+                                  MatchMode mode, const Deadline& deadline, SearchHits& hits) {
+    uint32_t size = static_cast<uint32_t>(segment.entries.size());
+    if (remaining_terms.empty()) {
+        for (uint32_t i = 0; i < size; ++i) {
+            hits.push_back({segment.entries[i].action, segment.base + i, SCORE_ACTIVATED});
+        }
+    } else if (mayMatch(segment, remaining_terms, mode)) {
+        searchSlice(segment, 0, size, remaining_terms, mode, deadline, hits);
+    }
+}
+
+void SearchIndex::searchSliceAll(const Segment& segment, uint32_t begin, uint32_t end, const std::vector<std::string>& folded_terms,
+                                 const Deadline& deadline, SearchHits& hits) {
+    // Longest terms first: they match least, so later terms only test the survivors
+    std::vector<const std::string*> terms;
+    for (const auto& term : folded_terms) {
+        terms.push_back(&term);
+    }
+    std::stable_sort(terms.begin(), terms.end(),
+                     [](const std::string* a, const std::string* b) { return a->size() > b->size(); });
+
+    size_t count = end - begin;
+    DynamicBitset candidates(count, true);
+    DynamicBitset term_matches(count);
+    std::vector<uint32_t> scores(count, 0);
+    for (const std::string* term : terms) {
+        // Out of time: nothing is known to match every term yet
+        if (deadline.expired()) {
+            return;
+        }
+        term_matches.assign(count, false);
+        candidates.forEachSet([&](size_t i) {
+            uint32_t score = scoreTerm(segment, segment.entries[begin + i], *term);
+            if (score > 0) {
+                term_matches.set(i);
+                scores[i] += score;
+            }
+        });
+        candidates &= term_matches;
+        if (candidates.none()) {
+            return;
+        }
+    }
+
+    candidates.forEachSet([&](size_t i) {
+        hits.push_back({segment.entries[begin + i].action, segment.base + static_cast<uint32_t>(begin + i), scores[i]});
+    });
+}
+
+void SearchIndex::selectTop(SearchHits& hits, size_t max_results) {
+    if (max_results > 0 && hits.size() > max_results) {
+        std::partial_sort(hits.begin(), hits.begin() + max_results, hits.end(), rankBefore);
+        hits.resize(max_results);
+    } else {
+        std::sort(hits.begin(), hits.end(), rankBefore);
+    }
+}
+
+void SearchIndex::searchShard(const Shard& shard, const std::vector<std::string>& folded_terms,
+                              size_t max_results, const Deadline& deadline, SearchHits& hits) const {
+    bool use_trigrams = usesTrigrams(folded_terms, match_mode_);
+    // Groups that may contain every term go first, so a budget cut loses the weakest groups
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1 && match_mode_ == MatchMode::ALL) {
+            break;
+        }
+        for (const auto& slice : shard.slices) {
+            if (deadline.expired()) {
+                break;
+            }
+            const Segment& segment = segments_[slice.segment];
+            bool has_all = mayMatch(segment, folded_terms, MatchMode::ALL);
+            if (pass == 0 ? has_all : !has_all && mayMatch(segment, folded_terms, MatchMode::ANY)) {
+                if (use_trigrams) {
+                    searchSliceTrigrams(segment, slice.begin, slice.end, folded_terms, match_mode_, deadline, hits);
+                } else {
+                    searchSlice(segment, slice.begin, slice.end, folded_terms, match_mode_, deadline, hits);
+                }
+            }
+        }
+    }
+    selectTop(hits, max_results);
+}
+
+SearchHits SearchIndex::search(const std::vector<std::string>& folded_terms, size_t max_results, bool* truncated,
+                               std::pmr::memory_resource* memory) const {
+    Deadline deadline(budget_);
+    SearchHits hits(memory);
+    search(folded_terms, max_results, deadline, hits);
+    if (truncated) {
+        *truncated = deadline.expired();
+    }
+    return hits;
+}
+
+void SearchIndex::search(const std::vector<std::string>& folded_terms, size_t max_results, const Deadline& deadline,
+                         SearchHits& hits) const {
+    if (folded_terms.empty() || total_entries_ == 0) {
+        return;
+    }
+
+    // A leading term equal to a group's prefix restricts the search to those groups
+    if (has_activation_prefixes_) {
+        std::vector<std::string> remaining_terms(folded_terms.begin() + 1, folded_terms.end());
+        bool activated = false;
+        for (const auto& segment : segments_) {
+            if (!segment.prefix.empty() && segment.prefix == folded_terms[0]) {
+                searchActivated(segment, remaining_terms, match_mode_, deadline, hits);
+                activated = true;
+            }
+        }
+        if (activated) {
+            selectTop(hits, max_results);
+            return;
+        }
+    }
+
+    if (isShortQuery(folded_terms)) {
+        searchPrefixList(folded_terms[0], max_results, hits);
+        return;
+    }
+
+    if (!pool_ || shards_.size() == 1) {
+        searchShard(shards_.front(), folded_terms, max_results, deadline, hits);
+        return;
+    }
+
+    // Every shard keeps its own top-K, the merge re-ranks their union with the same total order.
+    // Workers use the default resource: the caller's arena belongs to this thread.
+    std::vector<SearchHits> partial(shards_.size());
+    pool_->run(shards_.size(), [&](size_t s) {
+        searchShard(shards_[s], folded_terms, max_results, deadline, partial[s]);
+    });
+
+    size_t total = 0;
+    for (const auto& shard_hits : partial) {
+        total += shard_hits.size();
+    }
+    hits.reserve(total);
+    for (const auto& shard_hits : partial) {
+        hits.insert(hits.end(), shard_hits.begin(), shard_hits.end());
+    }
+    selectTop(hits, max_results);
+}
+
+} // namespace PrimeCuts
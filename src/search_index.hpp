@@ -0,0 +1,192 @@
+#pragma once
+
+#include "config.hpp"
+#include "dynamic_bitset.hpp"
+#include "trigram_index.hpp"
+#include "worker_pool.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PrimeCuts {
+
+// How the terms of a multi-term query combine
+enum class MatchMode {
+    ANY,    // An action matching any term is a result
+    ALL,    // Every term has to match
+    RANKED  // Any term, but actions matching more terms rank first
+};
+
+struct SearchHit {
+    const Action* action;
+    uint32_t ordinal; // Position of the action in config order
+    uint32_t score;
+};
+
+// Allocated from the caller's memory resource, usually the request arena
+using SearchHits = std::pmr::vector<SearchHit>;
+
+// Case-folded copy of the searchable text of every action, one segment per group.
+// The actions are partitioned into shards that are searched in parallel on a fixed
+// worker pool; the merged result is identical to a sequential scan.
+// Single terms of one or two characters only match at word starts of names and
+// keywords; their ranked results are precomputed per group and merged by lookup.
+// Groups whose character bitmaps rule out the terms are skipped without touching
+// their actions, and a query starting with a group's prefix only searches that group.
+// Terms of three or more characters take their candidates from each group's compressed
+// trigram index; only those candidates are scored. As every group is indexed on its
+// own, changing one group only re-indexes that group.
+class SearchIndex {
+public:
+    SearchIndex() = default;
+    ~SearchIndex() = default;
+
+    // Delete copy constructor and assignment operator
+    SearchIndex(const SearchIndex&) = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    void build(const Config& config);
+    void rebuildGroup(size_t group_index, const Group& group);
+    // One batch of group changes: drops the segments flagged in removed (indexes before the
+    // change), then re-indexes changed_groups (indexes into config after it) in parallel.
+    // Ordinals and shards are recomputed once.
+    void updateGroups(const Config& config, const std::vector<bool>& removed, std::vector<size_t> changed_groups);
+    void setShardCount(size_t shard_count);
+    size_t shardCount() const { return shard_count_; }
+    void setMatchMode(MatchMode mode) { match_mode_ = mode; }
+    // 0 = unlimited; otherwise a search returns the best hits found when the budget runs out
+    void setTimeBudget(std::chrono::microseconds budget) { budget_ = budget; }
+    MatchMode matchMode() const { return match_mode_; }
+    size_t size() const { return total_entries_; }
+    size_t memoryUsage() const;
+    size_t postingMemoryUsage() const;
+
+    // Ranked by score, ties in config order. max_results == 0 returns every match.
+    // truncated reports whether the time budget cut the search short.
+    SearchHits search(const std::vector<std::string>& folded_terms, size_t max_results, bool* truncated = nullptr,
+                      std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+
+    // Linear scan of a config without building an index, ranked like search()
+    static SearchHits scan(const Config& config, const std::vector<std::string>& folded_terms, size_t max_results,
+                           MatchMode mode = MatchMode::ANY);
+
+    static std::string fold(std::string_view text);
+    static bool parseMatchMode(const std::string& value, MatchMode& mode);
+
+private:
+    // End of a search's time budget, shared by the shard workers. Once seen expired it stays expired.
+    class Deadline {
+    public:
+        Deadline() = default;
+        explicit Deadline(std::chrono::microseconds budget);
+        bool expired() const;
+
+    private:
+        bool enabled_ = false;
+        std::chrono::steady_clock::time_point at_;
+        mutable std::atomic<bool> expired_{false};
+    };
+
+    struct Field {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct Entry {
+        const Action* action = nullptr;
+        Field name;
+        Field keywords; // All keywords, separated by KEYWORD_SEPARATOR
+        Field description;
+        Field id;
+    };
+
+    // Bytes and hashed byte pairs occurring in a segment's text. A term with a byte
+    // or pair that is missing cannot be a substring of any of the group's fields.
+    struct GroupFilter {
+        std::array<uint64_t, 4> bytes{};
+        std::array<uint64_t, 64> pairs{};
+
+        void build(std::string_view text);
+        bool mayContain(std::string_view term) const;
+    };
+
+    // Ranked entry indexes of every action with a name or keyword word starting with key:
+    // [begin, name_end) matched a name word, [name_end, end) only a keyword
+    struct PrefixList {
+        uint32_t key;
+        uint32_t begin;
+        uint32_t name_end;
+        uint32_t end;
+    };
+
+    struct Segment {
+        uint32_t base = 0; // Ordinal of the first entry
+        std::string text;
+        std::vector<Entry> entries;
+        std::string prefix; // Folded activation prefix of the group
+        GroupFilter filter;
+        std::vector<PrefixList> prefix_lists; // Sorted by key
+        std::vector<uint32_t> prefix_entries;
+        TrigramIndex trigrams; // By entry index
+    };
+
+    // Contiguous range of one segment's entries
+    struct Slice {
+        uint32_t segment;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Shard {
+        std::vector<Slice> slices;
+    };
+
+    static constexpr char KEYWORD_SEPARATOR = '\x1f';
+
+    std::vector<Segment> segments_;
+    std::vector<Shard> shards_;
+    size_t shard_count_ = 1;
+    size_t total_entries_ = 0;
+    MatchMode match_mode_ = MatchMode::ANY;
+    std::chrono::microseconds budget_{0};
+    std::unique_ptr<WorkerPool> pool_;
+    bool has_activation_prefixes_ = false;
+
+    static void buildSegment(const Group& group, Segment& segment);
+    static void indexSegment(Segment& segment);
+    static void buildPrefixLists(Segment& segment);
+    static void buildTrigrams(Segment& segment);
+    static uint32_t scoreTerm(const Segment& segment, const Entry& entry, std::string_view term);
+    static uint32_t scoreEntry(const Segment& segment, const Entry& entry, const std::vector<std::string>& folded_terms,
+                               MatchMode mode);
+    static void searchSlice(const Segment& segment, uint32_t begin, uint32_t end, const std::vector<std::string>& folded_terms,
+                            MatchMode mode, const Deadline& deadline, SearchHits& hits);
+    static bool mayMatch(const Segment& segment, const std::vector<std::string>& folded_terms, MatchMode mode);
+    static void searchActivated(const Segment& segment, const std::vector<std::string>& remaining_terms,
+                                MatchMode mode, const Deadline& deadline, SearchHits& hits);
+    static void searchSliceAll(const Segment& segment, uint32_t begin, uint32_t end, const std::vector<std::string>& folded_terms,
+                               const Deadline& deadline, SearchHits& hits);
+    static bool usesTrigrams(const std::vector<std::string>& folded_terms, MatchMode mode);
+    static void searchSliceTrigrams(const Segment& segment, uint32_t begin, uint32_t end,
+                                    const std::vector<std::string>& folded_terms, MatchMode mode,
+                                    const Deadline& deadline, SearchHits& hits);
+    static void selectTop(SearchHits& hits, size_t max_results);
+    static bool isShortQuery(const std::vector<std::string>& folded_terms);
+
+    void indexGroups(const Config& config, const std::vector<size_t>& group_indexes);
+    void updateOrdinals();
+    void assignShards();
+    void search(const std::vector<std::string>& folded_terms, size_t max_results, const Deadline& deadline,
+                SearchHits& hits) const;
+    void searchPrefixList(const std::string& folded_term, size_t max_results, SearchHits& hits) const;
+    void searchShard(const Shard& shard, const std::vector<std::string>& folded_terms,
+                     size_t max_results, const Deadline& deadline, SearchHits& hits) const;
+};
+
+} // namespace PrimeCuts
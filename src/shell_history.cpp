@@ -0,0 +1,140 @@
+#include "shell_history.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PrimeCuts {
+
+namespace {
+
+std::string_view trimView(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+bool allDigits(std::string_view text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+}
+
+} // anonymous namespace
+
+bool ShellHistory::update(const std::string& path, size_t max_items) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+
+    if (static_cast<uint64_t>(st.st_ino) != inode_ || size < offset_) {
+        clear();
+        inode_ = static_cast<uint64_t>(st.st_ino);
+    }
+    if (size == offset_) {
+        close(fd);
+        return true;
+    }
+
+    // Map from the page holding the check bytes, mmap offsets must be page aligned
+    uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t check_start = offset_ - check_.size();
+    uint64_t map_start = check_start - check_start % page;
+    size_t map_length = static_cast<size_t>(size - map_start);
+    void* data = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(map_start));
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, map_length, MADV_SEQUENTIAL);
+
+    const char* mapped = static_cast<const char*>(data);
+    auto at = [&](uint64_t file_offset) { return mapped + (file_offset - map_start); };
+    if (std::string_view(at(check_start), check_.size()) != check_) {
+        // Same file but rewritten in place, as bash does without histappend
+        munmap(data, map_length);
+        clear();
+        return update(path, max_items);
+    }
+
+    std::string_view tail(at(offset_), static_cast<size_t>(size - offset_));
+    size_t pos = 0;
+    size_t end;
+    // A line without its newline yet is read by the next update
+    while ((end = tail.find('\n', pos)) != std::string_view::npos) {
+        addLine(tail.substr(pos, end - pos), max_items);
+        pos = end + 1;
+    }
+    offset_ += pos;
+
+    size_t check_length = static_cast<size_t>(std::min<uint64_t>(offset_, CHECK_BYTES));
+    check_.assign(at(offset_ - check_length), check_length);
+    munmap(data, map_length);
+    return true;
+}
+
+void ShellHistory::clear() {
+    inode_ = 0;
+    offset_ = 0;
+    check_.clear();
+    continued_ = false;
+    index_.clear();
+    commands_.clear();
+    generation_++;
+}
+
+void ShellHistory::addLine(std::string_view line, size_t max_items) {
+    bool was_continued = continued_;
+    continued_ = !line.empty() && line.back() == '\\';
+    if (was_continued || continued_) {
+        return;
+    }
+
+    // zsh extended history: ": <start>:<duration>;command"
+    if (line.size() > 2 && line[0] == ':' && line[1] == ' ') {
+        size_t separator = line.find(';');
+        if (separator != std::string_view::npos) {
+            line = line.substr(separator + 1);
+        }
+    }
+    // bash HISTTIMEFORMAT stores "#<time>" lines in front of each command
+    if (!line.empty() && line[0] == '#' && allDigits(line.substr(1))) {
+        return;
+    }
+
+    line = trimView(line);
+    if (line.empty() || line.size() > MAX_COMMAND_LENGTH) {
+        return;
+    }
+
+    auto it = index_.find(line);
+    if (it != index_.end()) {
+        // Running the latest command again, as without ignoredups, changes nothing
+        if (it->second != std::prev(commands_.end())) {
+            commands_.splice(commands_.end(), commands_, it->second);
+            generation_++;
+        }
+        return;
+    }
+
+    commands_.emplace_back(line);
+    generation_++;
+    index_.emplace(commands_.back(), std::prev(commands_.end()));
+    while (commands_.size() > max_items && !commands_.empty()) {
+        index_.erase(commands_.front());
+        commands_.pop_front();
+    }
+}
+
+} // namespace PrimeCuts
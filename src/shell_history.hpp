@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace PrimeCuts {
+
+// Distinct commands of a bash or zsh history file, at most max_items of them. A
+// command that is run again moves to the most recent position instead of being
+// added twice. update() only reads what was appended since the previous call; a
+// file that was replaced, truncated or rewritten is read again from the start.
+class ShellHistory {
+public:
+    // Longer lines are skipped, they are rarely something to run again
+    static constexpr size_t MAX_COMMAND_LENGTH = 4096;
+
+    // Returns false if the file cannot be read
+    bool update(const std::string& path, size_t max_items);
+
+    template <typename Function>
+    void forEachRecentFirst(Function function) const {
+        for (auto it = commands_.rbegin(); it != commands_.rend(); ++it) {
+            function(*it);
+        }
+    }
+
+    size_t size() const { return commands_.size(); }
+    // Changes whenever a command is added, dropped or moved, so a caller can tell
+    // whether the list it built from the history is still current
+    uint64_t generation() const { return generation_; }
+
+private:
+    // Bytes before offset_ that must still be in the file for the tail to be new
+    static constexpr size_t CHECK_BYTES = 64;
+
+    uint64_t inode_ = 0;
+    uint64_t offset_ = 0;
+    std::string check_;
+    bool continued_ = false; // Inside a multi-line command, which is skipped
+    uint64_t generation_ = 1; // 0 names no list, so a caller starting at 0 always builds
+    std::list<std::string> commands_; // Oldest first
+    std::unordered_map<std::string_view, std::list<std::string>::iterator> index_; // Views into commands_
+
+    void clear();
+    void addLine(std::string_view line, size_t max_items);
+};
+
+} // namespace PrimeCuts
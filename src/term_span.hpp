@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Non-owning view of search terms. The strings usually live in the D-Bus message,
+// so a query is not copied before it is folded.
+class TermSpan {
+public:
+    TermSpan() = default;
+    TermSpan(const std::string_view* data, size_t size) : data_(data), size_(size) {}
+    TermSpan(const std::vector<std::string_view>& terms) : data_(terms.data()), size_(terms.size()) {}
+
+    const std::string_view* begin() const { return data_; }
+    const std::string_view* end() const { return data_ + size_; }
+    const std::string_view& operator[](size_t index) const { return data_[index]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const std::string_view* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Views of terms that are already owned as std::string
+inline std::vector<std::string_view> viewTerms(const std::vector<std::string>& terms) {
+    return std::vector<std::string_view>(terms.begin(), terms.end());
+}
+
+} // namespace PrimeCuts
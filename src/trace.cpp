@@ -0,0 +1,347 @@
+#include "trace.hpp"
+#include "constants.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+namespace PrimeCuts {
+
+namespace {
+
+const char TRACE_MAGIC[4] = {'P', 'C', 'T', 'R'};
+const uint8_t TRACE_VERSION = 1;
+const uint8_t TRACE_FLAG_ANONYMIZED = 1;
+const size_t TRACE_KEY_BYTES = 32;
+const char TRACE_TERM_ALPHABET[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+bool methodFromName(const gchar* method_name, TraceMethod& method) {
+    if (g_strcmp0(method_name, Constants::METHOD_GET_INITIAL_RESULT_SET) == 0) {
+        method = TraceMethod::GET_INITIAL_RESULT_SET;
+    } else if (g_strcmp0(method_name, Constants::METHOD_GET_SUBSEARCH_RESULT_SET) == 0) {
+        method = TraceMethod::GET_SUBSEARCH_RESULT_SET;
+    } else if (g_strcmp0(method_name, Constants::METHOD_GET_RESULT_METAS) == 0) {
+        method = TraceMethod::GET_RESULT_METAS;
+    } else if (g_strcmp0(method_name, Constants::METHOD_ACTIVATE_RESULT) == 0) {
+        method = TraceMethod::ACTIVATE_RESULT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[static_cast<size_t>(fraction * (sorted.size() - 1))];
+}
+
+} // anonymous namespace
+
+const char* traceMethodName(TraceMethod method) {
+    switch (method) {
+        case TraceMethod::GET_INITIAL_RESULT_SET: return Constants::METHOD_GET_INITIAL_RESULT_SET;
+        case TraceMethod::GET_SUBSEARCH_RESULT_SET: return Constants::METHOD_GET_SUBSEARCH_RESULT_SET;
+        case TraceMethod::GET_RESULT_METAS: return Constants::METHOD_GET_RESULT_METAS;
+        case TraceMethod::ACTIVATE_RESULT: return Constants::METHOD_ACTIVATE_RESULT;
+    }
+    return "Unknown";
+}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const std::string& path, bool anonymize) {
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR("Cannot open trace file: " + path);
+        return false;
+    }
+
+    anonymize_ = anonymize;
+    key_.clear();
+    if (anonymize_) {
+        std::random_device random;
+        for (size_t i = 0; i < TRACE_KEY_BYTES; ++i) {
+            key_ += static_cast<char>(random() & 0xff);
+        }
+    }
+
+    fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+    uint8_t header[2] = {TRACE_VERSION, static_cast<uint8_t>(anonymize_ ? TRACE_FLAG_ANONYMIZED : 0)};
+    fwrite(header, 1, sizeof(header), file_);
+    fflush(file_);
+
+    last_call_time_ = 0;
+    LOG_INFO("Recording D-Bus trace to " + path + (anonymize_ ? " (anonymized)" : ""));
+    return true;
+}
+
+void TraceRecorder::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void TraceRecorder::record(const gchar* method_name, GVariant* parameters) {
+    TraceMethod method;
+    if (!file_ || !methodFromName(method_name, method)) {
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    buffer_.clear();
+    writeVarint(last_call_time_ == 0 ? 0 : static_cast<uint64_t>(now - last_call_time_));
+    buffer_ += static_cast<char>(method);
+    last_call_time_ = now;
+
+    switch (method) {
+        case TraceMethod::GET_INITIAL_RESULT_SET: {
+            GVariant* terms = g_variant_get_child_value(parameters, 0);
+            writeStringArray(terms, true);
+            g_variant_unref(terms);
+            break;
+        }
+        case TraceMethod::GET_SUBSEARCH_RESULT_SET: {
+            GVariant* previous_results = g_variant_get_child_value(parameters, 0);
+            GVariant* terms = g_variant_get_child_value(parameters, 1);
+            writeStringArray(previous_results, false);
+            writeStringArray(terms, true);
+            g_variant_unref(previous_results);
+            g_variant_unref(terms);
+            break;
+        }
+        case TraceMethod::GET_RESULT_METAS: {
+            GVariant* ids = g_variant_get_child_value(parameters, 0);
+            writeStringArray(ids, false);
+            g_variant_unref(ids);
+            break;
+        }
+        case TraceMethod::ACTIVATE_RESULT: {
+            const gchar* id;
+            GVariant* terms;
+            guint32 timestamp;
+            g_variant_get(parameters, "(&s@asu)", &id, &terms, &timestamp);
+            writeString(id, false);
+            writeStringArray(terms, true);
+            writeVarint(timestamp);
+            g_variant_unref(terms);
+            break;
+        }
+    }
+
+    // Flushed per call so a trace survives the service being killed
+    fwrite(buffer_.data(), 1, buffer_.size(), file_);
+    fflush(file_);
+}
+
+void TraceRecorder::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer_ += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer_ += static_cast<char>(value);
+}
+
+void TraceRecorder::writeString(const char* str, bool is_term) {
+    size_t length = strlen(str);
+    if (anonymize_ && !is_term) {
+        std::string id = anonymizedId(str, length);
+        writeVarint(id.size());
+        buffer_ += id;
+        return;
+    }
+
+    writeVarint(length);
+    size_t start = buffer_.size();
+    buffer_.append(str, length);
+    if (anonymize_) {
+        anonymizeTerm(start);
+    }
+}
+
+// Byte i becomes a character of HMAC(key, digest of bytes 0..i-1, byte i): equal prefixes
+// stay equal, but the same byte maps differently in every context, non-ASCII included
+void TraceRecorder::anonymizeTerm(size_t start) {
+    guint8 digest[32] = {};
+    gsize digest_length = sizeof(digest);
+    for (size_t i = start; i < buffer_.size(); ++i) {
+        guint8 byte = static_cast<guint8>(buffer_[i]);
+        GHmac* hmac = g_hmac_new(G_CHECKSUM_SHA256, reinterpret_cast<const guchar*>(key_.data()), key_.size());
+        g_hmac_update(hmac, digest, static_cast<gssize>(digest_length));
+        g_hmac_update(hmac, &byte, 1);
+        digest_length = sizeof(digest);
+        g_hmac_get_digest(hmac, digest, &digest_length);
+        g_hmac_unref(hmac);
+        buffer_[i] = TRACE_TERM_ALPHABET[digest[0] % (sizeof(TRACE_TERM_ALPHABET) - 1)];
+    }
+}
+
+// Ids name hosts, files and bookmarks; they become 16 hex digits of their HMAC
+std::string TraceRecorder::anonymizedId(const char* id, size_t length) const {
+    gchar* hex = g_compute_hmac_for_data(G_CHECKSUM_SHA256, reinterpret_cast<const guchar*>(key_.data()), key_.size(),
+                                         reinterpret_cast<const guchar*>(id), length);
+    std::string result(hex, 16);
+    g_free(hex);
+    return result;
+}
+
+void TraceRecorder::writeStringArray(GVariant* array, bool is_term) {
+    gsize count = 0;
+    const gchar** strings = g_variant_get_strv(array, &count);
+    writeVarint(count);
+    for (gsize i = 0; i < count; ++i) {
+        writeString(strings[i], is_term);
+    }
+    g_free(strings);
+}
+
+bool TraceReader::open(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot open trace file: " + path);
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    data_ = buffer.str();
+
+    if (data_.size() < 6 || data_.compare(0, sizeof(TRACE_MAGIC), TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        LOG_ERROR("Not a PrimeCuts trace file: " + path);
+        return false;
+    }
+    if (static_cast<uint8_t>(data_[4]) != TRACE_VERSION) {
+        LOG_ERROR("Unsupported trace version " + std::to_string(static_cast<uint8_t>(data_[4])));
+        return false;
+    }
+
+    anonymized_ = (static_cast<uint8_t>(data_[5]) & TRACE_FLAG_ANONYMIZED) != 0;
+    pos_ = 6;
+    return true;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (pos_ >= data_.size()) {
+        return false;
+    }
+
+    if (!readVarint(record.delay_us) || pos_ >= data_.size()) {
+        return false;
+    }
+    record.method = static_cast<TraceMethod>(static_cast<uint8_t>(data_[pos_++]));
+
+    GVariant* parameters = nullptr;
+    switch (record.method) {
+        case TraceMethod::GET_INITIAL_RESULT_SET:
+        case TraceMethod::GET_RESULT_METAS: {
+            GVariant* array = readStringArray();
+            if (array) parameters = g_variant_new("(@as)", array);
+            break;
+        }
+        case TraceMethod::GET_SUBSEARCH_RESULT_SET: {
+            GVariant* previous_results = readStringArray();
+            GVariant* terms = previous_results ? readStringArray() : nullptr;
+            if (terms) {
+                parameters = g_variant_new("(@as@as)", previous_results, terms);
+            } else if (previous_results) {
+                g_variant_unref(g_variant_ref_sink(previous_results));
+            }
+            break;
+        }
+        case TraceMethod::ACTIVATE_RESULT: {
+            std::string id;
+            uint64_t timestamp = 0;
+            if (!readString(id)) break;
+            GVariant* terms = readStringArray();
+            if (!terms) break;
+            if (!readVarint(timestamp)) {
+                g_variant_unref(g_variant_ref_sink(terms));
+                break;
+            }
+            parameters = g_variant_new("(s@asu)", id.c_str(), terms, static_cast<guint32>(timestamp));
+            break;
+        }
+    }
+
+    if (!parameters) {
+        LOG_ERROR("Truncated or corrupt trace record at offset " + std::to_string(pos_));
+        return false;
+    }
+    record.parameters = g_variant_ref_sink(parameters);
+    return true;
+}
+
+bool TraceReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TraceReader::readString(std::string& str) {
+    uint64_t length = 0;
+    if (!readVarint(length) || length > data_.size() - pos_) {
+        return false;
+    }
+    str.assign(data_, pos_, length);
+    pos_ += length;
+    return true;
+}
+
+GVariant* TraceReader::readStringArray() {
+    uint64_t count = 0;
+    if (!readVarint(count)) {
+        return nullptr;
+    }
+
+    std::vector<std::string> strings;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string str;
+        if (!readString(str)) {
+            return nullptr;
+        }
+        strings.push_back(str);
+    }
+
+    std::vector<const gchar*> pointers;
+    for (const auto& str : strings) {
+        pointers.push_back(str.c_str());
+    }
+    return g_variant_new_strv(pointers.data(), pointers.size());
+}
+
+void LatencyReport::add(const std::string& method, double microseconds) {
+    samples_[method].push_back(microseconds);
+}
+
+void LatencyReport::print() const {
+    std::cout << std::left << std::setw(24) << "method" << std::right << std::setw(8) << "calls"
+              << std::setw(10) << "min us" << std::setw(10) << "p50 us" << std::setw(10) << "p90 us"
+              << std::setw(10) << "p99 us" << std::setw(10) << "max us" << std::setw(10) << "mean us" << std::endl;
+
+    for (const auto& [method, unsorted] : samples_) {
+        std::vector<double> sorted = unsorted;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+
+        std::cout << std::left << std::setw(24) << method << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << sorted.size() << std::setw(10) << sorted.front()
+                  << std::setw(10) << percentile(sorted, 0.5) << std::setw(10) << percentile(sorted, 0.9)
+                  << std::setw(10) << percentile(sorted, 0.99) << std::setw(10) << sorted.back()
+                  << std::setw(10) << mean << std::endl;
+    }
+}
+
+} // namespace PrimeCuts
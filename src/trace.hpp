@@ -0,0 +1,91 @@
+#pragma once
+
+#include <gio/gio.h>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Compact binary trace of SearchProvider2 calls:
+//   header:  "PCTR" <version:u8> <flags:u8>
+//   record:  <delay_us:varint> <method:u8> <arguments>
+// Strings are <length:varint><bytes>, string arrays <count:varint><string>...
+enum class TraceMethod : uint8_t {
+    GET_INITIAL_RESULT_SET = 1,
+    GET_SUBSEARCH_RESULT_SET = 2,
+    GET_RESULT_METAS = 3,
+    ACTIVATE_RESULT = 4
+};
+
+class TraceRecorder {
+public:
+    TraceRecorder() = default;
+    ~TraceRecorder();
+
+    // Delete copy constructor and assignment operator
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // With anonymize, every byte of a search term is replaced by a character derived from
+    // a keyed hash of the term up to that byte, so lengths and prefix relations between
+    // consecutive queries stay intact. Result ids are replaced by a keyed hash. The key is
+    // random per trace and never written.
+    bool open(const std::string& path, bool anonymize);
+    void close();
+    void record(const gchar* method_name, GVariant* parameters);
+
+private:
+    FILE* file_ = nullptr;
+    bool anonymize_ = false;
+    gint64 last_call_time_ = 0;
+    std::string key_; // Anonymization key
+    std::string buffer_;
+
+    void writeVarint(uint64_t value);
+    void writeString(const char* str, bool is_term);
+    void writeStringArray(GVariant* array, bool is_term);
+    void anonymizeTerm(size_t start);
+    std::string anonymizedId(const char* id, size_t length) const;
+};
+
+struct TraceRecord {
+    uint64_t delay_us = 0;
+    TraceMethod method = TraceMethod::GET_INITIAL_RESULT_SET;
+    GVariant* parameters = nullptr; // Owned, matches the D-Bus signature of the method
+};
+
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader() = default;
+
+    bool open(const std::string& path);
+    bool next(TraceRecord& record);
+    bool isAnonymized() const { return anonymized_; }
+
+private:
+    std::string data_;
+    size_t pos_ = 0;
+    bool anonymized_ = false;
+
+    bool readVarint(uint64_t& value);
+    bool readString(std::string& str);
+    GVariant* readStringArray();
+};
+
+// Latency samples per method, printed as a distribution
+class LatencyReport {
+public:
+    void add(const std::string& method, double microseconds);
+    void print() const;
+
+private:
+    std::map<std::string, std::vector<double>> samples_;
+};
+
+const char* traceMethodName(TraceMethod method);
+
+} // namespace PrimeCuts
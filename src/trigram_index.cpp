@@ -0,0 +1,283 @@
+#include "trigram_index.hpp"
+#include <algorithm>
+
+namespace PrimeCuts {
+
+namespace {
+
+const size_t TRIGRAM_LENGTH = 3;
+
+uint32_t trigramKey(std::string_view text, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+template <typename Keys>
+void collectTrigrams(std::string_view text, Keys& keys) {
+    for (size_t pos = 0; pos + TRIGRAM_LENGTH <= text.size(); ++pos) {
+        keys.push_back(trigramKey(text, pos));
+    }
+}
+
+void appendVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+} // anonymous namespace
+
+void TrigramIndex::clear() {
+    lists_.clear();
+    containers_.clear();
+    bytes_.clear();
+    bitmaps_.clear();
+    entry_count_ = 0;
+    posting_count_ = 0;
+    pending_ids_.clear();
+    pending_.clear();
+    pending_chunk_ = 0;
+}
+
+void TrigramIndex::add(uint32_t ordinal, const std::vector<std::string_view>& fields) {
+    if ((ordinal >> CHUNK_BITS) != pending_chunk_) {
+        flushChunk();
+        pending_chunk_ = ordinal >> CHUNK_BITS;
+    }
+
+    entry_keys_.clear();
+    for (const auto& field : fields) {
+        collectTrigrams(field, entry_keys_);
+    }
+    std::sort(entry_keys_.begin(), entry_keys_.end());
+    entry_keys_.erase(std::unique(entry_keys_.begin(), entry_keys_.end()), entry_keys_.end());
+
+    for (uint32_t key : entry_keys_) {
+        auto [it, inserted] = pending_ids_.try_emplace(key, static_cast<uint32_t>(pending_.size()));
+        if (inserted) {
+            pending_.push_back({key, {}, {}});
+        }
+        pending_[it->second].offsets.push_back(static_cast<uint16_t>(ordinal & 0xffff));
+    }
+    posting_count_ += entry_keys_.size();
+}
+
+void TrigramIndex::flushChunk() {
+    for (auto& list : pending_) {
+        if (list.offsets.empty()) {
+            continue;
+        }
+
+        encode_buffer_.clear();
+        uint32_t previous = 0;
+        for (uint16_t offset : list.offsets) {
+            appendVarint(encode_buffer_, offset - previous);
+            previous = offset;
+        }
+
+        Container container;
+        container.chunk = static_cast<uint16_t>(pending_chunk_);
+        container.count = static_cast<uint32_t>(list.offsets.size());
+        if (encode_buffer_.size() < CHUNK_WORDS * sizeof(uint64_t)) {
+            container.type = ContainerType::ARRAY;
+            container.offset = static_cast<uint32_t>(bytes_.size());
+            bytes_.insert(bytes_.end(), encode_buffer_.begin(), encode_buffer_.end());
+        } else {
+            container.type = ContainerType::BITMAP;
+            container.offset = static_cast<uint32_t>(bitmaps_.size());
+            bitmaps_.resize(bitmaps_.size() + CHUNK_WORDS, 0);
+            uint64_t* words = bitmaps_.data() + container.offset;
+            for (uint16_t offset : list.offsets) {
+                words[offset / 64] |= uint64_t(1) << (offset % 64);
+            }
+        }
+        list.containers.push_back(container);
+        list.offsets.clear();
+    }
+}
+
+void TrigramIndex::finish(uint32_t entry_count) {
+    flushChunk();
+    entry_count_ = entry_count;
+
+    std::sort(pending_.begin(), pending_.end(),
+              [](const PendingList& a, const PendingList& b) { return a.key < b.key; });
+    lists_.reserve(pending_.size());
+    for (const auto& list : pending_) {
+        uint32_t begin = static_cast<uint32_t>(containers_.size());
+        containers_.insert(containers_.end(), list.containers.begin(), list.containers.end());
+        lists_.push_back({list.key, begin, static_cast<uint32_t>(containers_.size())});
+    }
+
+    // Only the compact form stays resident
+    pending_ = std::vector<PendingList>();
+    pending_ids_ = std::unordered_map<uint32_t, uint32_t>();
+    entry_keys_ = std::vector<uint32_t>();
+    encode_buffer_ = std::vector<uint8_t>();
+    lists_.shrink_to_fit();
+    containers_.shrink_to_fit();
+    bytes_.shrink_to_fit();
+    bitmaps_.shrink_to_fit();
+}
+
+bool TrigramIndex::prepare(std::string_view term, TermQuery& query) const {
+    query.lists.clear();
+    query.cursors.clear();
+    if (term.size() < TRIGRAM_LENGTH) {
+        return false;
+    }
+
+    std::pmr::vector<uint32_t> keys(query.lists.get_allocator());
+    collectTrigrams(term, keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    for (uint32_t key : keys) {
+        auto it = std::lower_bound(lists_.begin(), lists_.end(), key,
+                                   [](const List& list, uint32_t value) { return list.key < value; });
+        if (it == lists_.end() || it->key != key) {
+            return false;
+        }
+        query.lists.push_back(static_cast<uint32_t>(it - lists_.begin()));
+        query.cursors.push_back(it->container_begin);
+    }
+    return true;
+}
+
+bool TrigramIndex::intersectChunk(TermQuery& query, uint32_t chunk, uint32_t begin, uint32_t end,
+                                  std::pmr::vector<uint16_t>& offsets) const {
+    offsets.clear();
+    query.chunk_containers.clear();
+    for (size_t i = 0; i < query.lists.size(); ++i) {
+        const List& list = lists_[query.lists[i]];
+        uint32_t& cursor = query.cursors[i];
+        while (cursor < list.container_end && containers_[cursor].chunk < chunk) {
+            cursor++;
+        }
+        if (cursor == list.container_end || containers_[cursor].chunk != chunk) {
+            return false;
+        }
+        query.chunk_containers.push_back(cursor);
+    }
+    if (query.chunk_containers.empty()) {
+        return false;
+    }
+
+    // Arrays first, shortest first: the smallest list bounds the result and is cheapest to walk
+    std::sort(query.chunk_containers.begin(), query.chunk_containers.end(), [this](uint32_t a, uint32_t b) {
+        const Container& x = containers_[a];
+        const Container& y = containers_[b];
+        if (x.type != y.type) return x.type == ContainerType::ARRAY;
+        return x.count < y.count;
+    });
+    const Container& first = containers_[query.chunk_containers.front()];
+    if (first.type == ContainerType::BITMAP) {
+        intersectBitmaps(query, begin, end, offsets);
+        return !offsets.empty();
+    }
+
+    decodeArray(first, begin, end, offsets);
+    for (size_t i = 1; i < query.chunk_containers.size() && !offsets.empty(); ++i) {
+        const Container& container = containers_[query.chunk_containers[i]];
+        if (container.type == ContainerType::BITMAP) {
+            keepInBitmap(container, offsets);
+        } else {
+            keepInArray(container, offsets);
+        }
+    }
+    return !offsets.empty();
+}
+
+namespace {
+
+// Walks the delta + varint offsets of an array container in increasing order
+class ArrayReader {
+public:
+    ArrayReader(const uint8_t* data, uint32_t count) : data_(data), remaining_(count) {}
+
+    bool next(uint32_t& value) {
+        if (remaining_ == 0) {
+            return false;
+        }
+        remaining_--;
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = *data_++;
+            delta |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        value_ += delta;
+        value = value_;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    uint32_t remaining_;
+    uint32_t value_ = 0;
+};
+
+} // anonymous namespace
+
+void TrigramIndex::decodeArray(const Container& container, uint32_t begin, uint32_t end,
+                               std::pmr::vector<uint16_t>& offsets) const {
+    ArrayReader reader(bytes_.data() + container.offset, container.count);
+    uint32_t value;
+    while (reader.next(value) && value < end) {
+        if (value >= begin) {
+            offsets.push_back(static_cast<uint16_t>(value));
+        }
+    }
+}
+
+// Sorted merge, offsets only shrinks
+void TrigramIndex::keepInArray(const Container& container, std::pmr::vector<uint16_t>& offsets) const {
+    ArrayReader reader(bytes_.data() + container.offset, container.count);
+    size_t kept = 0;
+    size_t i = 0;
+    uint32_t value;
+    while (i < offsets.size() && reader.next(value)) {
+        while (i < offsets.size() && offsets[i] < value) {
+            i++;
+        }
+        if (i < offsets.size() && offsets[i] == value) {
+            offsets[kept++] = offsets[i++];
+        }
+    }
+    offsets.resize(kept);
+}
+
+void TrigramIndex::keepInBitmap(const Container& container, std::pmr::vector<uint16_t>& offsets) const {
+    const uint64_t* words = bitmaps_.data() + container.offset;
+    offsets.erase(std::remove_if(offsets.begin(), offsets.end(),
+                                 [words](uint16_t offset) { return ((words[offset / 64] >> (offset % 64)) & 1) == 0; }),
+                  offsets.end());
+}
+
+// Every container of the chunk is a bitmap; only the words covering [begin, end) are read
+void TrigramIndex::intersectBitmaps(const TermQuery& query, uint32_t begin, uint32_t end,
+                                    std::pmr::vector<uint16_t>& offsets) const {
+    for (size_t w = begin / 64; w < (end + 63) / 64; ++w) {
+        uint64_t word = ~uint64_t(0);
+        for (uint32_t index : query.chunk_containers) {
+            word &= bitmaps_[containers_[index].offset + w];
+            if (word == 0) break;
+        }
+        for (; word != 0; word &= word - 1) {
+            uint32_t offset = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+            if (offset >= begin && offset < end) {
+                offsets.push_back(static_cast<uint16_t>(offset));
+            }
+        }
+    }
+}
+
+size_t TrigramIndex::memoryUsage() const {
+    return lists_.capacity() * sizeof(List) + containers_.capacity() * sizeof(Container) +
+           bytes_.capacity() + bitmaps_.capacity() * sizeof(uint64_t);
+}
+
+} // namespace PrimeCuts
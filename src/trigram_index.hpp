@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Inverted index from folded trigrams to the ordinals of the entries containing them.
+// Postings are split into chunks of 65536 ordinals like roaring bitmaps: a chunk is
+// stored as delta + varint encoded offsets, or as a plain bitmap once that is smaller.
+// Queries combine one chunk at a time as sorted offsets: arrays are merged, probed
+// against bitmaps, and only two bitmaps are ANDed word by word.
+class TrigramIndex {
+public:
+    static constexpr uint32_t CHUNK_BITS = 16;
+    static constexpr size_t CHUNK_WORDS = (size_t(1) << CHUNK_BITS) / 64;
+
+    // Lists of one term's trigrams and how far a query has walked through them
+    struct TermQuery {
+        explicit TermQuery(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : lists(memory), cursors(memory), chunk_containers(memory) {}
+
+        std::pmr::vector<uint32_t> lists;   // Indexes into lists_
+        std::pmr::vector<uint32_t> cursors; // Next container per list, queries advance chunk by chunk
+        std::pmr::vector<uint32_t> chunk_containers; // Containers of the current chunk, smallest first
+    };
+
+    TrigramIndex() = default;
+    ~TrigramIndex() = default;
+
+    // Delete copy constructor and assignment operator
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+    TrigramIndex(TrigramIndex&&) = default;
+    TrigramIndex& operator=(TrigramIndex&&) = default;
+
+    void clear();
+    // Must be called with increasing ordinals; trigrams never span two fields
+    void add(uint32_t ordinal, const std::vector<std::string_view>& fields);
+    void finish(uint32_t entry_count);
+
+    // False if some trigram of the term occurs nowhere. Terms need at least 3 characters.
+    bool prepare(std::string_view term, TermQuery& query) const;
+    // Replaces offsets with the sorted offsets in [begin, end) of the chunk that contain
+    // every trigram of the term; false if there are none
+    bool intersectChunk(TermQuery& query, uint32_t chunk, uint32_t begin, uint32_t end,
+                        std::pmr::vector<uint16_t>& offsets) const;
+
+    uint32_t chunkCount() const { return (entry_count_ + (uint32_t(1) << CHUNK_BITS) - 1) >> CHUNK_BITS; }
+    size_t listCount() const { return lists_.size(); }
+    size_t postingCount() const { return posting_count_; }
+    size_t memoryUsage() const;
+
+private:
+    enum class ContainerType : uint8_t {
+        ARRAY,  // count varint deltas in bytes_
+        BITMAP  // CHUNK_WORDS words in bitmaps_
+    };
+
+    struct Container {
+        uint16_t chunk;
+        ContainerType type;
+        uint32_t count;
+        uint32_t offset;
+    };
+
+    struct List {
+        uint32_t key;
+        uint32_t container_begin;
+        uint32_t container_end;
+    };
+
+    // Postings of the current chunk, per list, while building
+    struct PendingList {
+        uint32_t key;
+        std::vector<uint16_t> offsets;
+        std::vector<Container> containers;
+    };
+
+    std::vector<List> lists_; // Sorted by key
+    std::vector<Container> containers_;
+    std::vector<uint8_t> bytes_;
+    std::vector<uint64_t> bitmaps_;
+    uint32_t entry_count_ = 0;
+    size_t posting_count_ = 0;
+
+    std::unordered_map<uint32_t, uint32_t> pending_ids_;
+    std::vector<PendingList> pending_;
+    uint32_t pending_chunk_ = 0;
+    std::vector<uint32_t> entry_keys_;
+    std::vector<uint8_t> encode_buffer_;
+
+    void flushChunk();
+    void decodeArray(const Container& container, uint32_t begin, uint32_t end, std::pmr::vector<uint16_t>& offsets) const;
+    void keepInArray(const Container& container, std::pmr::vector<uint16_t>& offsets) const;
+    void keepInBitmap(const Container& container, std::pmr::vector<uint16_t>& offsets) const;
+    void intersectBitmaps(const TermQuery& query, uint32_t begin, uint32_t end, std::pmr::vector<uint16_t>& offsets) const;
+};
+
+} // namespace PrimeCuts
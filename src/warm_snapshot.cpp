@@ -0,0 +1,335 @@
+#include "warm_snapshot.hpp"
+#include "atomic_file.hpp"
+#include "constants.hpp"
+#include "logger.hpp"
+#include "search_index.hpp"
+#include <gio/gio.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PrimeCuts {
+
+namespace {
+
+const char MAGIC[8] = {'P', 'C', 'W', 'A', 'R', 'M', '\n', '\0'};
+
+} // anonymous namespace
+
+struct WarmSnapshot::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t next_session_id;
+    uint64_t config_hash;
+    uint32_t query_count;
+    uint32_t action_count;
+    uint32_t result_count;
+    uint32_t strings_size;
+};
+
+struct WarmSnapshot::StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct WarmSnapshot::QueryRecord {
+    StringRef query;
+    uint32_t count;
+    uint32_t first_result;
+    uint32_t result_count;
+};
+
+struct WarmSnapshot::ActionRecord {
+    StringRef id;
+    StringRef name;
+    StringRef description;
+    StringRef icon;
+    StringRef clipboard_text;
+};
+
+void QueryCounter::record(std::string_view query, uint32_t count) {
+    if (query.empty()) {
+        return;
+    }
+    size_t hash = std::hash<std::string_view>{}(query);
+    auto it = counts_.find(hash);
+    if (it == counts_.end()) {
+        if (counts_.size() >= Constants::SNAPSHOT_TRACKED_QUERIES) {
+            for (auto entry = counts_.begin(); entry != counts_.end();) {
+                entry->second.count /= 2;
+                entry = entry->second.count == 0 ? counts_.erase(entry) : std::next(entry);
+            }
+        }
+        it = counts_.emplace(hash, Entry{std::string(query), 0}).first;
+    } else if (it->second.query != query) {
+        it->second = Entry{std::string(query), 0}; // Hash collision, the newer query takes the slot
+    }
+    it->second.count += count;
+    changed_ = true;
+}
+
+std::vector<std::pair<std::string, uint32_t>> QueryCounter::mostFrequent(size_t limit) const {
+    std::vector<std::pair<std::string, uint32_t>> queries;
+    queries.reserve(counts_.size());
+    for (const auto& [hash, entry] : counts_) {
+        queries.emplace_back(entry.query, entry.count);
+    }
+    auto more_frequent = [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    limit = std::min(limit, queries.size());
+    std::partial_sort(queries.begin(), queries.begin() + limit, queries.end(), more_frequent);
+    queries.resize(limit);
+    return queries;
+}
+
+WarmSnapshot::~WarmSnapshot() {
+    close();
+}
+
+bool WarmSnapshot::load(const std::string& path) {
+    close();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(st.st_size);
+
+    if (!validate()) {
+        close();
+        return false;
+    }
+    LOG_DEBUG("Warm snapshot holds " + std::to_string(query_count_) + " queries and "
+              + std::to_string(actions_.size()) + " actions");
+    return true;
+}
+
+void WarmSnapshot::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    queries_ = nullptr;
+    query_count_ = 0;
+    results_ = nullptr;
+    strings_ = nullptr;
+    actions_.clear();
+    action_ids_.clear();
+}
+
+// Every offset is checked once here, so lookups can trust the file
+bool WarmSnapshot::validate() {
+    if (size_ < sizeof(Header)) {
+        return false;
+    }
+    const Header* header = reinterpret_cast<const Header*>(data_);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+        LOG_DEBUG("Ignoring warm snapshot of another format version");
+        return false;
+    }
+    uint64_t expected = sizeof(Header) + uint64_t(header->query_count) * sizeof(QueryRecord)
+        + uint64_t(header->action_count) * sizeof(ActionRecord)
+        + uint64_t(header->result_count) * sizeof(uint32_t) + header->strings_size;
+    if (expected != size_) {
+        LOG_WARNING("Ignoring truncated warm snapshot");
+        return false;
+    }
+
+    const char* cursor = data_ + sizeof(Header);
+    queries_ = reinterpret_cast<const QueryRecord*>(cursor);
+    cursor += header->query_count * sizeof(QueryRecord);
+    const ActionRecord* actions = reinterpret_cast<const ActionRecord*>(cursor);
+    cursor += header->action_count * sizeof(ActionRecord);
+    results_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += header->result_count * sizeof(uint32_t);
+    strings_ = cursor;
+
+    auto valid = [&](const StringRef& ref) {
+        return uint64_t(ref.offset) + ref.length < header->strings_size && strings_[ref.offset + ref.length] == '\0';
+    };
+    for (uint32_t i = 0; i < header->action_count; ++i) {
+        const ActionRecord& record = actions[i];
+        if (!valid(record.id) || !valid(record.name) || !valid(record.description) ||
+            !valid(record.icon) || !valid(record.clipboard_text)) {
+            return false;
+        }
+        actions_.push_back({text(record.id), text(record.name), text(record.description),
+                            text(record.icon), text(record.clipboard_text)});
+        action_ids_.emplace(actions_.back().id, i);
+    }
+    for (uint32_t i = 0; i < header->query_count; ++i) {
+        const QueryRecord& record = queries_[i];
+        if (!valid(record.query) || uint64_t(record.first_result) + record.result_count > header->result_count) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->result_count; ++i) {
+        if (results_[i] >= header->action_count) {
+            return false;
+        }
+    }
+    query_count_ = header->query_count;
+    return true;
+}
+
+std::string_view WarmSnapshot::text(const StringRef& ref) const {
+    return std::string_view(strings_ + ref.offset, ref.length);
+}
+
+bool WarmSnapshot::lookup(std::string_view query, ResultIds& ids) const {
+    const QueryRecord* end = queries_ + query_count_;
+    const QueryRecord* record = std::lower_bound(queries_, end, query, [this](const QueryRecord& a, std::string_view b) {
+        return text(a.query) < b;
+    });
+    if (record == end || text(record->query) != query) {
+        return false;
+    }
+    for (uint32_t i = 0; i < record->result_count; ++i) {
+        ids.emplace_back(actions_[results_[record->first_result + i]].id);
+    }
+    return true;
+}
+
+const SnapshotAction* WarmSnapshot::findAction(std::string_view id) const {
+    auto it = action_ids_.find(id);
+    return it != action_ids_.end() ? &actions_[it->second] : nullptr;
+}
+
+uint64_t WarmSnapshot::configHash() const {
+    return data_ ? reinterpret_cast<const Header*>(data_)->config_hash : 0;
+}
+
+uint32_t WarmSnapshot::nextSessionId() const {
+    return data_ ? reinterpret_cast<const Header*>(data_)->next_session_id : 0;
+}
+
+void WarmSnapshot::restoreCounts(QueryCounter& counter) const {
+    bool changed = counter.changed();
+    for (size_t i = 0; i < query_count_; ++i) {
+        counter.record(text(queries_[i].query), queries_[i].count);
+    }
+    if (!changed) {
+        counter.clearChanged(); // Only new searches make the snapshot worth writing again
+    }
+}
+
+bool WarmSnapshot::write(const std::string& path, size_t config_hash, const CommandManager& manager,
+                         HotQueries queries, uint32_t next_session_id) {
+    gint64 start = g_get_monotonic_time();
+    std::sort(queries.begin(), queries.end());
+
+    std::string strings;
+    auto add_string = [&strings](std::string_view value) {
+        StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings.append(value);
+        strings += '\0';
+        return ref;
+    };
+
+    std::vector<QueryRecord> records;
+    std::vector<ActionRecord> actions;
+    std::unordered_map<std::string, uint32_t> ordinals; // By id, an action may move between queries
+    std::vector<uint32_t> results;
+    std::vector<std::string> folded_terms;
+    for (const auto& [query, count] : queries) {
+        folded_terms.clear();
+        for (size_t start_pos = 0; start_pos < query.size();) {
+            size_t space = std::min(query.find(' ', start_pos), query.size());
+            folded_terms.push_back(query.substr(start_pos, space - start_pos));
+            start_pos = space + 1;
+        }
+
+        // Hits point into the manager's actions, which may only change between queries
+        auto lock = manager.lockForReading();
+        QueryRecord record{add_string(query), count, static_cast<uint32_t>(results.size()), 0};
+        for (const auto& hit : manager.rankActions(folded_terms)) {
+            auto [it, added] = ordinals.emplace(hit.action->id, static_cast<uint32_t>(actions.size()));
+            if (added) {
+                const std::string* clipboard_text = hit.action->extra_params.find(Constants::PARAM_CLIPBOARD_TEXT);
+                actions.push_back({add_string(hit.action->id), add_string(hit.action->name),
+                                   add_string(hit.action->description), add_string(hit.action->icon),
+                                   add_string(clipboard_text ? *clipboard_text : std::string())});
+            }
+            results.push_back(it->second);
+            record.result_count++;
+        }
+        records.push_back(record);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.next_session_id = next_session_id;
+    header.config_hash = config_hash;
+    header.query_count = static_cast<uint32_t>(records.size());
+    header.action_count = static_cast<uint32_t>(actions.size());
+    header.result_count = static_cast<uint32_t>(results.size());
+    header.strings_size = static_cast<uint32_t>(strings.size());
+
+    gchar* directory = g_path_get_dirname(path.c_str());
+    g_mkdir_with_parents(directory, 0700);
+    g_free(directory);
+
+    AtomicFile file(path);
+    if (!file.open()) {
+        LOG_WARNING("Cannot write warm snapshot: " + file.error());
+        return false;
+    }
+    auto bytes = [](const auto* data, size_t count) {
+        return std::string_view(reinterpret_cast<const char*>(data), count * sizeof(*data));
+    };
+    file.write(bytes(&header, 1));
+    file.write(bytes(records.data(), records.size()));
+    file.write(bytes(actions.data(), actions.size()));
+    file.write(bytes(results.data(), results.size()));
+    file.write(strings);
+    if (!file.commit()) {
+        LOG_WARNING("Cannot write warm snapshot: " + file.error());
+        return false;
+    }
+    LOG_DEBUG("Wrote warm snapshot with " + std::to_string(records.size()) + " queries in "
+              + std::to_string((g_get_monotonic_time() - start) / 1000.0) + " ms");
+    return true;
+}
+
+// Folds like SearchIndex::fold, without a temporary string per term
+std::pmr::string WarmSnapshot::queryKey(TermSpan terms, std::pmr::memory_resource* memory) {
+    std::pmr::string key(memory);
+    for (const auto& term : terms) {
+        if (term.empty()) {
+            continue;
+        }
+        if (!key.empty()) {
+            key += ' ';
+        }
+        for (unsigned char c : term) {
+            key += static_cast<char>(std::tolower(c));
+        }
+    }
+    return key;
+}
+
+std::string WarmSnapshot::defaultPath() {
+    gchar* path = g_build_filename(g_get_user_cache_dir(), Constants::SNAPSHOT_FILENAME, nullptr);
+    std::string result = path;
+    g_free(path);
+    return result;
+}
+
+} // namespace PrimeCuts
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "command_manager.hpp"
+#include "term_span.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace PrimeCuts {
+
+// An action as far as GetResultMetas needs it; the views point into the mapped file
+// and are NUL-terminated
+struct SnapshotAction {
+    std::string_view id;
+    std::string_view name;
+    std::string_view description;
+    std::string_view icon;
+    std::string_view clipboard_text;
+};
+
+// How often each query was searched. When SNAPSHOT_TRACKED_QUERIES distinct queries
+// are counted, every count is halved and the queries that drop to zero are forgotten.
+// Counts are found by the hash of the query, so only a new query allocates.
+class QueryCounter {
+public:
+    void record(std::string_view query, uint32_t count = 1);
+    // Most frequent first
+    std::vector<std::pair<std::string, uint32_t>> mostFrequent(size_t limit) const;
+    bool changed() const { return changed_; }
+    void clearChanged() { changed_ = false; }
+
+private:
+    struct Entry {
+        std::string query;
+        uint32_t count = 0;
+    };
+
+    std::unordered_map<size_t, Entry> counts_; // By hash of the query
+    bool changed_ = false;
+};
+
+// Ranked results of the most frequent queries and the metas of their actions, written
+// on shutdown and periodically. The next start maps it before the config is parsed, so
+// the first keystrokes are answered while the index is built. Its results are only used
+// when the config files still hash to configHash().
+//
+// Layout: Header, QueryRecord[query_count] sorted by query, ActionRecord[action_count],
+// uint32_t results[result_count] (action ordinals), then the NUL-terminated strings.
+class WarmSnapshot {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    WarmSnapshot() = default;
+    ~WarmSnapshot();
+
+    // Delete copy constructor and assignment operator
+    WarmSnapshot(const WarmSnapshot&) = delete;
+    WarmSnapshot& operator=(const WarmSnapshot&) = delete;
+
+    bool load(const std::string& path);
+    void close();
+    bool isLoaded() const { return data_ != nullptr; }
+    uint64_t configHash() const;
+
+    // Appends the result ids of a query key; false if the query is not in the snapshot
+    bool lookup(std::string_view query, ResultIds& ids) const;
+    const SnapshotAction* findAction(std::string_view id) const;
+    uint32_t nextSessionId() const;
+    // Counts carry over, so queries of earlier sessions stay hot
+    void restoreCounts(QueryCounter& counter) const;
+
+    // Hot queries as taken from a QueryCounter on the main loop
+    using HotQueries = std::vector<std::pair<std::string, uint32_t>>;
+
+    // Ranks the hot queries against the current index and replaces the file. Runs on a
+    // worker thread; the manager is locked for reading one query at a time.
+    static bool write(const std::string& path, size_t config_hash, const CommandManager& manager,
+                      HotQueries queries, uint32_t next_session_id);
+    // Folded terms joined with spaces, allocated from memory (usually the request arena)
+    static std::pmr::string queryKey(TermSpan terms, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    static std::string defaultPath();
+
+private:
+    struct Header;
+    struct StringRef;
+    struct QueryRecord;
+    struct ActionRecord;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const QueryRecord* queries_ = nullptr;
+    size_t query_count_ = 0;
+    const uint32_t* results_ = nullptr;
+    const char* strings_ = nullptr;
+    std::vector<SnapshotAction> actions_;
+    std::unordered_map<std::string_view, uint32_t> action_ids_;
+
+    bool validate();
+    std::string_view text(const StringRef& ref) const;
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,79 @@
+#include "worker_pool.hpp"
+
+namespace PrimeCuts {
+
+WorkerPool::WorkerPool(size_t thread_count) {
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t task_count, const std::function<void(size_t)>& task) {
+    if (task_count == 0) {
+        return;
+    }
+    if (threads_.empty() || task_count == 1) {
+        for (size_t i = 0; i < task_count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_count_ = task_count;
+    next_task_ = 0;
+    pending_tasks_ = task_count;
+    generation_++;
+    work_cv_.notify_all();
+
+    while (runNextTask(lock)) {
+    }
+    done_cv_.wait(lock, [this] { return pending_tasks_ == 0; });
+    task_ = nullptr;
+}
+
+bool WorkerPool::runNextTask(std::unique_lock<std::mutex>& lock) {
+    if (!task_ || next_task_ >= task_count_) {
+        return false;
+    }
+
+    size_t index = next_task_++;
+    const auto* task = task_;
+    lock.unlock();
+    (*task)(index);
+    lock.lock();
+
+    if (--pending_tasks_ == 0) {
+        done_cv_.notify_all();
+    }
+    return true;
+}
+
+void WorkerPool::workerLoop() {
+    size_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+        if (stopping_) {
+            return;
+        }
+        seen_generation = generation_;
+        while (runNextTask(lock)) {
+        }
+    }
+}
+
+} // namespace PrimeCuts
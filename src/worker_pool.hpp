@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PrimeCuts {
+
+// Fixed set of threads that run the tasks of one batch in parallel. The calling
+// thread takes part in the batch, so a pool of N threads gives N + 1 workers.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t thread_count);
+    ~WorkerPool();
+
+    // Delete copy constructor and assignment operator
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Runs task(0) .. task(task_count - 1) and returns once all of them are done
+    void run(size_t task_count, const std::function<void(size_t)>& task);
+
+    size_t threadCount() const { return threads_.size(); }
+
+private:
+    std::vector<std::thread> threads_;
+    std::mutex run_mutex_;   // One batch at a time
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t task_count_ = 0;
+    size_t next_task_ = 0;
+    size_t pending_tasks_ = 0;
+    size_t generation_ = 0;
+    bool stopping_ = false;
+
+    void workerLoop();
+    bool runNextTask(std::unique_lock<std::mutex>& lock);
+};
+
+} // namespace PrimeCuts
@@ -0,0 +1,80 @@
+#include "command_template.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using PrimeCuts::CommandTemplate;
+using PrimeCuts::TermSpan;
+
+namespace {
+
+int failures = 0;
+
+std::string fill(std::string_view command, const std::vector<std::string_view>& terms,
+                 CommandTemplate::Escaping escaping = CommandTemplate::Escaping::SHELL) {
+    std::string out;
+    CommandTemplate::compile(command, escaping).fill(TermSpan(terms.data(), terms.size()), out);
+    return out;
+}
+
+void expectEqual(std::string_view what, const std::string& actual, std::string_view expected) {
+    if (actual != expected) {
+        std::cerr << "FAIL " << what << ": got [" << actual << "], expected [" << expected << "]" << std::endl;
+        failures++;
+    }
+}
+
+// Runs the filled command through sh and compares what it prints with the query
+void expectShellPrints(std::string_view command, const std::vector<std::string_view>& terms, std::string_view expected) {
+    std::string filled = fill(command, terms);
+    FILE* pipe = popen(filled.c_str(), "r");
+    if (!pipe) {
+        std::cerr << "FAIL could not run: " << filled << std::endl;
+        failures++;
+        return;
+    }
+    std::string output;
+    char buffer[256];
+    size_t count = 0;
+    while ((count = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, count);
+    }
+    pclose(pipe);
+    expectEqual(filled, output, expected);
+}
+
+} // anonymous namespace
+
+int main() {
+    const std::vector<std::string_view> hostile = {"it's", "$(touch /tmp/pwned)", "\"`id`\\"};
+    const std::string query = "it's $(touch /tmp/pwned) \"`id`\\";
+
+    // Unquoted placeholders become one single-quoted word
+    expectEqual("unquoted", fill("grep {query} notes", {"a b", "c"}), "grep 'a b c' notes");
+    expectEqual("unquoted quote", fill("echo {term1}", {"it's"}), "echo 'it'\\''s'");
+
+    // Inside quotes only the escaped body is inserted
+    expectEqual("single quoted", fill("echo '{query}'", {"a", "b"}), "echo 'a b'");
+    expectEqual("single quoted quote", fill("echo '{term1}'", {"it's"}), "echo 'it'\\''s'");
+    expectEqual("double quoted", fill("echo \"{query}\"", {"$HOME", "`id`"}), "echo \"\\$HOME \\`id\\`\"");
+    expectEqual("double quoted after single", fill("echo 'x' \"{term1}\"", {"a\"b"}), "echo 'x' \"a\\\"b\"");
+    expectEqual("escaped quote", fill("echo \\' {term1}", {"a b"}), "echo \\' 'a b'");
+    expectEqual("closed quotes", fill("echo 'x' {term1}", {"a b"}), "echo 'x' 'a b'");
+    expectEqual("url", fill("https://x/?q={query}", {"a b", "&"}, CommandTemplate::Escaping::URL),
+                "https://x/?q=a+b+%26");
+
+    // The shell sees the query exactly as typed, whatever quotes surround the placeholder
+    expectShellPrints("printf '%s' {query}", hostile, query);
+    expectShellPrints("printf '%s' '{query}'", hostile, query);
+    expectShellPrints("printf '%s' \"{query}\"", hostile, query);
+    expectShellPrints("printf '%s' \"[{term2}]\"", hostile, "[$(touch /tmp/pwned)]");
+
+    if (failures > 0) {
+        std::cerr << failures << " command template checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All command template checks passed" << std::endl;
+    return 0;
+}